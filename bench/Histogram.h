@@ -0,0 +1,101 @@
+#ifndef NetLib_BENCH_HISTOGRAM_H
+#define NetLib_BENCH_HISTOGRAM_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace thisptr {
+  namespace bench {
+
+    // HDR style log-linear histogram, every power of two range is split into 64 linear sub-buckets,
+    // so recorded values keep about two significant digits (< 1.6% error) over the whole 64-bit range.
+    class Histogram {
+      static constexpr int kSubBucketBits = 7;
+      static constexpr std::uint64_t kSubBuckets = 1ull << kSubBucketBits;
+      static constexpr std::uint64_t kHalfSubBuckets = kSubBuckets / 2;
+      static constexpr std::size_t kBuckets = (64 - kSubBucketBits + 2) * kHalfSubBuckets;
+
+    public:
+      Histogram() : m_counts(kBuckets, 0) {}
+
+      void record(std::uint64_t value) {
+        m_counts[index(value)]++;
+        m_count++;
+        m_sum += value;
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+      }
+
+      void merge(const Histogram& other) {
+        for (std::size_t i = 0; i < kBuckets; ++i)
+          m_counts[i] += other.m_counts[i];
+        m_count += other.m_count;
+        m_sum += other.m_sum;
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+      }
+
+      // highest value equivalent to the bucket the given percentile (0-100) falls into
+      std::uint64_t percentile(double p) const {
+        if (m_count == 0)
+          return 0;
+        auto rank = (std::uint64_t)(p / 100.0 * (double)m_count + 0.5);
+        rank = std::max<std::uint64_t>(1, std::min(rank, m_count));
+
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBuckets; ++i) {
+          seen += m_counts[i];
+          if (seen >= rank)
+            return std::min(highestEquivalent(i), m_max);
+        }
+        return m_max;
+      }
+
+      std::uint64_t count() const { return m_count; }
+      std::uint64_t min() const { return m_count ? m_min : 0; }
+      std::uint64_t max() const { return m_max; }
+      double mean() const { return m_count ? (double)m_sum / (double)m_count : 0.0; }
+
+    private:
+      static std::size_t index(std::uint64_t value) {
+        if (value < kSubBuckets)
+          return (std::size_t)value;
+        int msb = mostSignificantBit(value);
+        int shift = msb - (kSubBucketBits - 1);
+        return (std::size_t)((shift + 1) * kHalfSubBuckets + ((value >> shift) - kHalfSubBuckets));
+      }
+
+      static int mostSignificantBit(std::uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long msb;
+        _BitScanReverse64(&msb, value);
+        return (int)msb;
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+      }
+
+      static std::uint64_t highestEquivalent(std::size_t index) {
+        if (index < kSubBuckets)
+          return index;
+        std::uint64_t shift = index / kHalfSubBuckets - 1;
+        std::uint64_t sub = index % kHalfSubBuckets + kHalfSubBuckets;
+        return ((sub + 1) << shift) - 1;
+      }
+
+      std::vector<std::uint64_t> m_counts;
+      std::uint64_t m_count {0};
+      std::uint64_t m_sum {0};
+      std::uint64_t m_min {std::numeric_limits<std::uint64_t>::max()};
+      std::uint64_t m_max {0};
+    };
+  }
+}
+
+#endif //NetLib_BENCH_HISTOGRAM_H
@@ -0,0 +1,456 @@
+// Echo load generator. Starts an echo server on each selected backend and drives it with closed-loop
+// blocking clients, one thread per connection, for every combination of payload size, connection count
+// and worker count. Results are printed to stdout as a JSON array, progress goes to stderr.
+//
+//   netlib_bench [--backends blocking,pool,epoll,uring,asio,asio-percore,asio-sharded,asio-static] [--payloads 64,1024,16384]
+//                [--connections 1,16,64] [--workers 4] [--duration 5] [--warmup 1]
+//                [--address 127.0.0.1] [--port 7300]
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Net.h>
+#ifdef __linux__
+#include <EpollServer.h>
+#endif
+#if defined(__linux__) && defined(WITH_URING)
+#include <UringServer.h>
+#endif
+#include "Histogram.h"
+
+using namespace thisptr::net;
+using thisptr::bench::Histogram;
+using clock_type = std::chrono::steady_clock;
+
+struct Config {
+  std::vector<std::string> backends {"blocking", "pool", "epoll", "uring", "asio", "asio-percore", "asio-sharded", "asio-static"};
+  std::vector<std::size_t> payloads {64, 1024, 16384};
+  std::vector<int> connections {1, 16};
+  std::vector<int> workers {(int)std::max(1u, std::thread::hardware_concurrency())};
+  double duration {5};
+  double warmup {1};
+  std::string address {"127.0.0.1"};
+  int port {7300};
+};
+
+struct Run {
+  std::string backend;
+  std::size_t payload;
+  int connections;
+  int workers;
+};
+
+struct Result {
+  Run run;
+  std::string skipped;
+  double seconds {0};
+  std::uint64_t messages {0};
+  std::uint64_t errors {0};
+  Histogram latency;
+};
+
+// ---- echo handlers ----
+
+class BlockingEchoHandler: public BlockingTcpHandler {
+public:
+  void onMessage(std::string data) override {
+    if (m_conn->send(data.data(), (int)data.size()) < 0)
+      m_conn->close();
+  }
+};
+
+#ifdef WITH_ASIO
+class AsioEchoHandler: public std::enable_shared_from_this<AsioEchoHandler>,
+    public AsyncConnectionHandlerBase<AsioTcpSocket<AsioEchoHandler>> {
+public:
+  bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {
+    return !ec;
+  }
+
+  bool onBufferReceived(asio::ip::tcp::socket& sock, std::error_code ec, asio::const_buffer payload) override {
+    if (ec) {
+      m_conn->close();
+      return false;
+    }
+    m_conn->send(static_cast<const char*>(payload.data()), (int)payload.size());
+    return true;
+  }
+
+  void onDataSent(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {}
+
+  void onNewConnection(asio::ip::tcp::socket& sock) override {
+    // one handler per connection, the listening handler only hands them out
+    auto session = std::make_shared<AsioEchoHandler>();
+    session->m_conn = std::make_shared<AsioTcpSocket<AsioEchoHandler>>(sock, session);
+    session->m_conn->recv();
+  }
+
+private:
+  std::shared_ptr<AsioTcpSocket<AsioEchoHandler>> m_conn;
+};
+
+// same as AsioEchoHandler, but dispatched statically
+class AsioStaticEchoHandler: public StaticConnectionHandlerBase<AsioStaticEchoHandler> {
+public:
+  bool onBufferReceived(asio::ip::tcp::socket& sock, std::error_code ec, asio::const_buffer payload) {
+    if (ec) {
+      m_conn->close();
+      return false;
+    }
+    m_conn->send(static_cast<const char*>(payload.data()), (int)payload.size());
+    return true;
+  }
+
+  void onNewConnection(asio::ip::tcp::socket& sock) {
+    auto session = std::make_shared<AsioStaticEchoHandler>();
+    session->m_conn = std::make_shared<AsioTcpSocket<AsioStaticEchoHandler>>(sock, session);
+    session->m_conn->recv();
+  }
+
+private:
+  std::shared_ptr<AsioTcpSocket<AsioStaticEchoHandler>> m_conn;
+};
+#endif
+
+// ---- servers ----
+
+class EchoServer {
+public:
+  virtual ~EchoServer() = default;
+  virtual void start(const std::string& address, const std::string& port) = 0;
+  virtual void stop() = 0;
+};
+
+class BlockingEchoServer: public EchoServer {
+public:
+  explicit BlockingEchoServer(int workers) {
+    if (workers > 0)
+      m_server.setWorkerPool(workers);
+    m_server.setNewHandler([]() { return std::make_shared<BlockingEchoHandler>(); });
+  }
+
+  void start(const std::string& address, const std::string& port) override { m_server.start(address, port); }
+  void stop() override { m_server.stop(); }
+
+private:
+  BlockingTcpServer<BlockingEchoHandler> m_server;
+};
+
+#ifdef __linux__
+class EpollEchoServer: public EchoServer {
+public:
+  explicit EpollEchoServer(int workers) {
+    m_server.setWorkers(workers);
+    m_server.setNewHandler([]() { return std::make_shared<BlockingEchoHandler>(); });
+  }
+
+  void start(const std::string& address, const std::string& port) override { m_server.start(address, port); }
+  void stop() override { m_server.stop(); m_server.waitForFinished(); }
+
+private:
+  EpollTcpServer<BlockingEchoHandler> m_server;
+};
+#endif
+
+#if defined(__linux__) && defined(WITH_URING)
+class UringEchoServer: public EchoServer {
+public:
+  UringEchoServer() {
+    m_server.setNewHandler([]() { return std::make_shared<BlockingEchoHandler>(); });
+  }
+
+  void start(const std::string& address, const std::string& port) override { m_server.start(address, port); }
+  void stop() override { m_server.stop(); m_server.waitForFinished(); }
+
+private:
+  UringTcpServer<BlockingEchoHandler> m_server;
+};
+#endif
+
+#ifdef WITH_ASIO
+template <typename H>
+class AsioEchoServer: public EchoServer {
+public:
+  AsioEchoServer(int workers, bool contextPerWorker, bool sharded = false) : m_server(std::make_shared<H>()) {
+    m_server.setWorkers(workers, contextPerWorker);
+    if (sharded)
+      m_server.setShardedAccept();
+  }
+
+  void start(const std::string& address, const std::string& port) override { m_server.start(address, port); }
+  void stop() override { m_server.stop(); }
+
+private:
+  AsyncTcpServer<H> m_server;
+};
+#endif
+
+// returns nullptr and the reason if the backend is not available in this build
+std::unique_ptr<EchoServer> makeServer(const Run& run, std::string& reason) {
+  if (run.backend == "blocking")
+    return std::unique_ptr<EchoServer>(new BlockingEchoServer(0));
+  if (run.backend == "pool") {
+    // a pool worker serves one connection until it closes, the rest would wait in the queue
+    if (run.workers < run.connections) {
+      reason = "pool needs at least as many workers as connections";
+      return nullptr;
+    }
+    return std::unique_ptr<EchoServer>(new BlockingEchoServer(run.workers));
+  }
+#ifdef __linux__
+  if (run.backend == "epoll")
+    return std::unique_ptr<EchoServer>(new EpollEchoServer(run.workers));
+#endif
+#if defined(__linux__) && defined(WITH_URING)
+  if (run.backend == "uring")
+    return std::unique_ptr<EchoServer>(new UringEchoServer());
+#endif
+#ifdef WITH_ASIO
+  if (run.backend == "asio")
+    return std::unique_ptr<EchoServer>(new AsioEchoServer<AsioEchoHandler>(run.workers, false));
+  if (run.backend == "asio-percore")
+    return std::unique_ptr<EchoServer>(new AsioEchoServer<AsioEchoHandler>(run.workers, true));
+  if (run.backend == "asio-sharded")
+    return std::unique_ptr<EchoServer>(new AsioEchoServer<AsioEchoHandler>(run.workers, true, true));
+  if (run.backend == "asio-static")
+    return std::unique_ptr<EchoServer>(new AsioEchoServer<AsioStaticEchoHandler>(run.workers, false));
+#endif
+  reason = "backend not available in this build";
+  return nullptr;
+}
+
+// ---- load generator ----
+
+enum Phase { kWarmup, kMeasure, kDone };
+
+struct ClientStats {
+  Histogram latency;
+  std::uint64_t messages {0};
+  std::uint64_t errors {0};
+};
+
+bool connectWithRetry(BlockingTcpSocket& sock, const std::string& address, const std::string& port) {
+  for (int i = 0; i < 100; ++i) {
+    if (sock.connect(address, port) && sock.isOpen())
+      return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  return false;
+}
+
+void client(const Config& config, const Run& run, const std::string& port, std::atomic<int>& phase,
+            std::atomic<int>& ready, ClientStats& stats) {
+  BlockingTcpSocket sock;
+  if (!connectWithRetry(sock, config.address, port)) {
+    stats.errors++;
+    ready++;
+    return;
+  }
+
+  int noDelay = 1;
+  ::setsockopt(sock.handle(), IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+  // a stalled server must not hang the run
+#if defined(WIN32) || defined(WIN64)
+  DWORD timeout = 2000;
+#else
+  timeval timeout {2, 0};
+#endif
+  thisptr::net_p::setsockopt(sock.handle(), SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  std::string payload(run.payload, 'x');
+  std::vector<char> buffer(run.payload);
+  ready++;
+
+  while (phase != kDone) {
+    clock_type::time_point begin = clock_type::now();
+
+    std::size_t sent = 0;
+    while (sent < run.payload) {
+      int n = sock.send(payload.data() + sent, (int)(run.payload - sent));
+      if (n <= 0)
+        break;
+      sent += n;
+    }
+
+    std::size_t received = 0;
+    while (sent == run.payload && received < run.payload) {
+      int n = sock.recv(buffer.data() + received, (int)(run.payload - received));
+      if (n <= 0)
+        break;
+      received += n;
+    }
+
+    if (received != run.payload) {
+      stats.errors++;
+      break;
+    }
+
+    if (phase == kMeasure) {
+      stats.latency.record((std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - begin).count());
+      stats.messages++;
+    }
+  }
+  sock.close();
+}
+
+Result measure(const Config& config, const Run& run, int port) {
+  Result result;
+  result.run = run;
+
+  std::unique_ptr<EchoServer> server = makeServer(run, result.skipped);
+  if (!server)
+    return result;
+
+  std::string portStr = std::to_string(port);
+  server->start(config.address, portStr);
+
+  std::atomic<int> phase {kWarmup};
+  std::atomic<int> ready {0};
+  std::vector<ClientStats> stats(run.connections);
+  std::vector<std::thread> clients;
+  for (int i = 0; i < run.connections; ++i)
+    clients.emplace_back(client, std::cref(config), std::cref(run), std::cref(portStr), std::ref(phase),
+                         std::ref(ready), std::ref(stats[i]));
+
+  while (ready < run.connections)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  std::this_thread::sleep_for(std::chrono::duration<double>(config.warmup));
+  clock_type::time_point begin = clock_type::now();
+  phase = kMeasure;
+  std::this_thread::sleep_for(std::chrono::duration<double>(config.duration));
+  phase = kDone;
+  result.seconds = std::chrono::duration<double>(clock_type::now() - begin).count();
+
+  for (auto& t: clients)
+    t.join();
+  // give the server a moment to see the disconnects before it is torn down
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  server->stop();
+
+  for (auto& s: stats) {
+    result.latency.merge(s.latency);
+    result.messages += s.messages;
+    result.errors += s.errors;
+  }
+  return result;
+}
+
+// ---- output ----
+
+void printJson(std::ostream& out, const std::vector<Result>& results) {
+  auto us = [](std::uint64_t ns) { return (double)ns / 1000.0; };
+
+  out << std::fixed << std::setprecision(3) << "[" << std::endl;
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    out << "  {\"backend\": \"" << r.run.backend << "\", \"payload\": " << r.run.payload
+        << ", \"connections\": " << r.run.connections << ", \"workers\": " << r.run.workers;
+    if (!r.skipped.empty()) {
+      out << ", \"skipped\": \"" << r.skipped << "\"}";
+    } else {
+      double seconds = r.seconds > 0 ? r.seconds : 1;
+      out << ", \"seconds\": " << r.seconds << ", \"messages\": " << r.messages << ", \"errors\": " << r.errors
+          << ", \"msgs_per_sec\": " << (double)r.messages / seconds
+          << ", \"mb_per_sec\": " << (double)(r.messages * r.run.payload) / seconds / 1e6
+          << ", \"latency_us\": {\"min\": " << us(r.latency.min())
+          << ", \"mean\": " << r.latency.mean() / 1000.0
+          << ", \"p50\": " << us(r.latency.percentile(50))
+          << ", \"p90\": " << us(r.latency.percentile(90))
+          << ", \"p99\": " << us(r.latency.percentile(99))
+          << ", \"p99.9\": " << us(r.latency.percentile(99.9))
+          << ", \"max\": " << us(r.latency.max()) << "}}";
+    }
+    out << (i + 1 < results.size() ? "," : "") << std::endl;
+  }
+  out << "]" << std::endl;
+}
+
+// ---- arguments ----
+
+std::vector<std::string> split(const std::string& value) {
+  std::vector<std::string> items;
+  std::stringstream ss(value);
+  std::string item;
+  while (std::getline(ss, item, ','))
+    if (!item.empty())
+      items.push_back(item);
+  return items;
+}
+
+bool parseArgs(int argc, char** argv, Config& config) {
+  try {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "--help" || i + 1 >= argc)
+        return false;
+      std::string value = argv[++i];
+
+      if (arg == "--backends") {
+        config.backends = split(value);
+      } else if (arg == "--payloads") {
+        config.payloads.clear();
+        for (auto& item: split(value))
+          config.payloads.push_back(std::stoul(item));
+      } else if (arg == "--connections") {
+        config.connections.clear();
+        for (auto& item: split(value))
+          config.connections.push_back(std::stoi(item));
+      } else if (arg == "--workers") {
+        config.workers.clear();
+        for (auto& item: split(value))
+          config.workers.push_back(std::stoi(item));
+      } else if (arg == "--duration") {
+        config.duration = std::stod(value);
+      } else if (arg == "--warmup") {
+        config.warmup = std::stod(value);
+      } else if (arg == "--address") {
+        config.address = value;
+      } else if (arg == "--port") {
+        config.port = std::stoi(value);
+      } else {
+        return false;
+      }
+    }
+  } catch (std::exception& e) {
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  Config config;
+  if (!parseArgs(argc, argv, config)) {
+    std::cerr << "usage: " << argv[0] << " [--backends blocking,pool,epoll,uring,asio,asio-percore,asio-sharded,asio-static]"
+              << " [--payloads 64,1024,16384] [--connections 1,16] [--workers 4] [--duration 5] [--warmup 1]"
+              << " [--address 127.0.0.1] [--port 7300]" << std::endl;
+    return 1;
+  }
+
+  // the library logs to stdout, keep it for the json only
+  std::streambuf* out = std::cout.rdbuf(std::cerr.rdbuf());
+
+  std::vector<Result> results;
+  int port = config.port;
+  for (auto& backend: config.backends)
+    for (auto payload: config.payloads)
+      for (auto connections: config.connections)
+        for (auto workers: config.workers) {
+          Run run {backend, payload, connections, workers};
+          std::cerr << "running " << backend << ", payload " << payload << ", connections " << connections
+                    << ", workers " << workers << std::endl;
+          // a fresh port per run, the previous listener may still linger
+          results.push_back(measure(config, run, port++));
+        }
+
+  std::cout.rdbuf(out);
+  printJson(std::cout, results);
+  return 0;
+}
@@ -0,0 +1,69 @@
+#ifndef NetLib_BUFFERPOOL_H
+#define NetLib_BUFFERPOOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <Pool.h>
+
+namespace thisptr {
+  namespace net {
+
+    // Fixed-size receive slabs shared by all connections. Slabs beyond the pool capacity, or reads that
+    // need more than one slab, fall back to plain heap blocks which are freed on release.
+    class BufferPool {
+    public:
+      struct Slab {
+        char* data {nullptr};
+        std::size_t size {0};
+        bool pooled {false};
+      };
+
+      explicit BufferPool(std::size_t slabSize = 16 * 1024, std::size_t capacity = 8192);
+
+      static BufferPool& shared();
+
+      Slab acquire(std::size_t minSize = 0);
+      void release(Slab& slab);
+
+      std::size_t slabSize() const { return m_slabSize; }
+      // slabs and heap blocks acquired and not yet released
+      std::size_t outstanding() const { return m_outstanding.load(std::memory_order_relaxed); }
+
+    private:
+      std::size_t m_slabSize;
+      thisptr::utils::ThreadCachingPool<char> m_slabs;
+      std::atomic<std::size_t> m_outstanding {0};
+    };
+
+    // Contiguous receive buffer that only holds a slab while it has unconsumed data or a read is being
+    // prepared into it, the slab goes back to the pool as soon as everything is consumed.
+    class SlabBuffer {
+    public:
+      explicit SlabBuffer(BufferPool* pool = &BufferPool::shared()) : m_pool(pool) {}
+      ~SlabBuffer() { m_pool->release(m_slab); }
+
+      SlabBuffer(const SlabBuffer&) = delete;
+      SlabBuffer& operator=(const SlabBuffer&) = delete;
+
+      void setPool(BufferPool* pool);
+
+      const char* data() const { return m_slab.data + m_begin; }
+      std::size_t size() const { return m_end - m_begin; }
+      std::size_t capacity() const { return m_slab.data ? m_slab.size : m_pool->slabSize(); }
+      bool isLent() const { return m_slab.data != nullptr; }
+
+      // returns room for n more bytes behind the current data, borrowing or growing the slab if needed
+      char* prepare(std::size_t n);
+      void commit(std::size_t n);
+      void consume(std::size_t n);
+
+    private:
+      BufferPool* m_pool;
+      BufferPool::Slab m_slab;
+      std::size_t m_begin {0};
+      std::size_t m_end {0};
+    };
+  }
+}
+
+#endif //NetLib_BUFFERPOOL_H
@@ -0,0 +1,194 @@
+#ifndef NetLib_CONNECTIONPOOL_H
+#define NetLib_CONNECTIONPOOL_H
+
+#include <chrono>
+#include <unordered_map>
+#include <Net.h>
+
+namespace thisptr {
+  namespace net {
+
+    // Keyed pool of client connections (host:port -> idle connections) on top of utils::Pool.
+    // A borrowed connection goes back to its pool when the lease ends, idle ones are health checked before reuse.
+    // Leases must not outlive the ConnectionPool they were borrowed from.
+    template <typename S>
+    class ConnectionPool {
+    public:
+      using socket_type = S;
+      using connect_func = std::function<socket_type* (const std::string& host, const std::string& port)>;
+      using check_func = std::function<bool (socket_type*)>;
+      using clock = std::chrono::steady_clock;
+
+      struct Options {
+        std::size_t maxIdle {8};   // idle connections kept per host:port
+        std::size_t maxTotal {64}; // borrowed and idle connections per host:port
+        std::chrono::milliseconds idleTimeout {30000};
+        int borrowTimeout {0};     // ms to wait for a returned connection once maxTotal is reached
+      };
+
+    private:
+      struct Entry {
+        std::unique_ptr<socket_type> sock;
+        clock::time_point lastUsed;
+      };
+      using pool_type = thisptr::utils::Pool<Entry>;
+
+    public:
+      class Lease {
+      public:
+        Lease() = default;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        Lease(Lease&& other) noexcept : m_owner(other.m_owner), m_pool(other.m_pool), m_entry(other.m_entry) {
+          other.m_entry = nullptr;
+        }
+
+        Lease& operator=(Lease&& other) noexcept {
+          if (this != &other) {
+            release();
+            m_owner = other.m_owner;
+            m_pool = other.m_pool;
+            m_entry = other.m_entry;
+            other.m_entry = nullptr;
+          }
+          return *this;
+        }
+
+        ~Lease() {
+          release();
+        }
+
+        socket_type* get() const { return m_entry ? m_entry->sock.get() : nullptr; }
+        socket_type* operator->() const { return get(); }
+        explicit operator bool() const { return m_entry != nullptr; }
+
+        // hands the connection back for reuse
+        void release() {
+          if (m_entry)
+            m_owner->recycle(m_pool, m_entry, true);
+          m_entry = nullptr;
+        }
+
+        // the connection is broken or in an unknown protocol state, close it instead of reusing it
+        void invalidate() {
+          if (m_entry)
+            m_owner->recycle(m_pool, m_entry, false);
+          m_entry = nullptr;
+        }
+
+      private:
+        friend class ConnectionPool;
+        Lease(ConnectionPool* owner, pool_type* pool, Entry* entry) : m_owner(owner), m_pool(pool), m_entry(entry) {}
+
+        ConnectionPool* m_owner {nullptr};
+        pool_type* m_pool {nullptr};
+        Entry* m_entry {nullptr};
+      };
+
+      // connects with socket_type::connect and checks idle connections with socket_type::isHealthy
+      explicit ConnectionPool(Options options = Options()) :
+      ConnectionPool(&ConnectionPool::defaultConnect, &ConnectionPool::defaultCheck, options)
+      {}
+
+      ConnectionPool(connect_func connect, check_func check, Options options = Options()) :
+      m_connect(std::move(connect)), m_check(std::move(check)), m_options(options)
+      {}
+
+      ConnectionPool(const ConnectionPool&) = delete;
+      ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+      // the most recently used idle connection that passes the health check, or a new one.
+      // the lease is empty if connecting failed or maxTotal connections are borrowed already.
+      Lease borrow(const std::string& host, const std::string& port) {
+        pool_type* pool = poolFor(host, port);
+        while (true) {
+          Entry* entry = pool->pop(m_options.borrowTimeout);
+          if (!entry)
+            return Lease();
+
+          if (!entry->sock) {
+            // connect outside of the pool lock, so a slow handshake does not stall the other borrowers
+            entry->sock.reset(m_connect(host, port));
+            if (!entry->sock) {
+              pool->discard(entry);
+              return Lease();
+            }
+            return Lease(this, pool, entry);
+          }
+
+          if (clock::now() - entry->lastUsed > m_options.idleTimeout || !m_check(entry->sock.get())) {
+            pool->discard(entry);
+            continue;
+          }
+          return Lease(this, pool, entry);
+        }
+      }
+
+      // closes the connections that have been idle for longer than idleTimeout, returns how many
+      std::size_t evictIdle() {
+        std::vector<pool_type*> pools;
+        {
+          std::lock_guard<std::mutex> lk(m_mutex);
+          for (auto& it: m_pools)
+            pools.push_back(it.second.get());
+        }
+
+        clock::time_point deadline = clock::now() - m_options.idleTimeout;
+        std::size_t evicted = 0;
+        for (auto pool: pools)
+          evicted += pool->evict([deadline](Entry* entry) { return entry->lastUsed < deadline; });
+        return evicted;
+      }
+
+      std::size_t idle(const std::string& host, const std::string& port) {
+        return poolFor(host, port)->idle();
+      }
+
+    private:
+      static socket_type* defaultConnect(const std::string& host, const std::string& port) {
+        std::unique_ptr<socket_type> sock(new socket_type());
+        if (!sock->connect(host, port))
+          return nullptr;
+        return sock.release();
+      }
+
+      static bool defaultCheck(socket_type* sock) {
+        return sock->isHealthy();
+      }
+
+      pool_type* poolFor(const std::string& host, const std::string& port) {
+        std::string key = host + ":" + port;
+        std::lock_guard<std::mutex> lk(m_mutex);
+        auto it = m_pools.find(key);
+        if (it != m_pools.end())
+          return it->second.get();
+
+        // entries start out unconnected, borrow connects them
+        pool_type* pool = new pool_type([]() { return new Entry(); }, [](Entry* entry) { delete entry; }, m_options.maxTotal);
+        m_pools.emplace(key, std::unique_ptr<pool_type>(pool));
+        return pool;
+      }
+
+      void recycle(pool_type* pool, Entry* entry, bool reusable) {
+        if (!reusable || !entry->sock->isOpen() || pool->idle() >= m_options.maxIdle) {
+          pool->discard(entry);
+          return;
+        }
+        entry->lastUsed = clock::now();
+        pool->push(entry);
+      }
+
+      connect_func m_connect;
+      check_func m_check;
+      Options m_options;
+
+      std::mutex m_mutex;
+      std::unordered_map<std::string, std::unique_ptr<pool_type>> m_pools;
+    };
+
+    using BlockingConnectionPool = ConnectionPool<BlockingTcpSocket>;
+  }
+}
+
+#endif //NetLib_CONNECTIONPOOL_H
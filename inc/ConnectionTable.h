@@ -0,0 +1,168 @@
+#ifndef NetLib_CONNECTIONTABLE_H
+#define NetLib_CONNECTIONTABLE_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace thisptr {
+  namespace net {
+
+    // slot index in the low 32 bits, the slot's generation in the high ones. a closed connection's id
+    // never matches the next connection stored in the same slot, zero is never handed out
+    using ConnectionId = std::uint64_t;
+    static constexpr ConnectionId kInvalidConnection = 0;
+
+    // told by a socket stored in a ConnectionTable once it closed, so the slot can be reclaimed
+    class ConnectionOwner {
+    public:
+      virtual void release(ConnectionId id) = 0;
+
+    protected:
+      ~ConnectionOwner() = default;
+    };
+
+    // Objects constructed in place in fixed size chunks that never move, freed slots are reused through an
+    // intrusive free list. Lookup and removal by id are O(1) without hashing. The lock is recursive so
+    // destructors and forEach callbacks may use the table again.
+    template <typename T, std::size_t ChunkSize = 256>
+    class ConnectionTable {
+      static constexpr std::uint32_t kNone = 0xffffffffu;
+
+      struct Slot {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        std::uint32_t generation {1};
+        std::uint32_t nextFree {kNone};
+        bool used {false};
+
+        T* get() { return reinterpret_cast<T*>(&storage); }
+      };
+
+    public:
+      ConnectionTable() = default;
+      ~ConnectionTable() {
+        clear();
+      }
+
+      ConnectionTable(const ConnectionTable&) = delete;
+      ConnectionTable& operator=(const ConnectionTable&) = delete;
+
+      // constructs a T from args in a free slot, returns its id and address
+      template <typename ...Args>
+      std::pair<ConnectionId, T*> emplace(Args&& ...args) {
+        std::lock_guard<std::recursive_mutex> lk(m_mutex);
+        std::uint32_t index;
+        if (m_free != kNone) {
+          index = m_free;
+          m_free = slot(index).nextFree;
+        } else {
+          index = m_end++;
+          if (index % ChunkSize == 0)
+            m_chunks.emplace_back(new Slot[ChunkSize]);
+        }
+
+        Slot& s = slot(index);
+        try {
+          new (&s.storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+          s.nextFree = m_free;
+          m_free = index;
+          throw;
+        }
+        s.used = true;
+        m_count++;
+        return {makeId(index, s.generation), s.get()};
+      }
+
+      // nullptr once the connection was erased. the pointer is only safe to use while nothing can erase it,
+      // e.g. from the connection's own callbacks, visit it otherwise
+      T* find(ConnectionId id) {
+        std::lock_guard<std::recursive_mutex> lk(m_mutex);
+        Slot* s = lookup(id);
+        return s ? s->get() : nullptr;
+      }
+
+      // calls f(T&) under the table lock if the connection still exists
+      template <typename F>
+      bool visit(ConnectionId id, F&& f) {
+        std::lock_guard<std::recursive_mutex> lk(m_mutex);
+        Slot* s = lookup(id);
+        if (!s)
+          return false;
+        f(*s->get());
+        return true;
+      }
+
+      // calls f(ConnectionId, T&) for every stored connection
+      template <typename F>
+      void forEach(F&& f) {
+        std::lock_guard<std::recursive_mutex> lk(m_mutex);
+        for (std::uint32_t i = 0; i < m_end; ++i) {
+          Slot& s = slot(i);
+          if (s.used)
+            f(makeId(i, s.generation), *s.get());
+        }
+      }
+
+      bool erase(ConnectionId id) {
+        std::lock_guard<std::recursive_mutex> lk(m_mutex);
+        Slot* s = lookup(id);
+        if (!s)
+          return false;
+
+        // invalidate the id first, the destructor may look it up again
+        s->used = false;
+        if (++s->generation == 0)
+          s->generation = 1;
+        s->get()->~T();
+        s->nextFree = m_free;
+        m_free = (std::uint32_t)(id & 0xffffffffu);
+        m_count--;
+        return true;
+      }
+
+      void clear() {
+        std::lock_guard<std::recursive_mutex> lk(m_mutex);
+        for (std::uint32_t i = 0; i < m_end; ++i) {
+          Slot& s = slot(i);
+          if (s.used)
+            erase(makeId(i, s.generation));
+        }
+      }
+
+      std::size_t size() {
+        std::lock_guard<std::recursive_mutex> lk(m_mutex);
+        return m_count;
+      }
+
+    private:
+      static ConnectionId makeId(std::uint32_t index, std::uint32_t generation) {
+        return ((ConnectionId)generation << 32) | index;
+      }
+
+      Slot& slot(std::uint32_t index) {
+        return m_chunks[index / ChunkSize][index % ChunkSize];
+      }
+
+      Slot* lookup(ConnectionId id) {
+        auto index = (std::uint32_t)(id & 0xffffffffu);
+        if (index >= m_end)
+          return nullptr;
+        Slot& s = slot(index);
+        return s.used && s.generation == (std::uint32_t)(id >> 32) ? &s : nullptr;
+      }
+
+      std::recursive_mutex m_mutex;
+      std::vector<std::unique_ptr<Slot[]>> m_chunks;
+      std::uint32_t m_end {0};
+      std::uint32_t m_free {kNone};
+      std::size_t m_count {0};
+    };
+  }
+}
+
+#endif //NetLib_CONNECTIONTABLE_H
@@ -0,0 +1,334 @@
+#ifndef NetLib_EPOLLSERVER_H
+#define NetLib_EPOLLSERVER_H
+
+#ifdef __linux__
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <Net.h>
+#include <TimingWheel.h>
+
+namespace thisptr {
+  namespace net {
+
+    // Edge-triggered epoll server for BlockingTcpHandler based handlers.
+    // Connections are spread over a fixed number of reactor threads instead of one thread per connection,
+    // the handler callbacks of a connection are always invoked from the same reactor thread.
+    template <typename H>
+    class EpollTcpServer: public TcpServerBase {
+      using handler_type = H;
+      using handler_ptr = std::shared_ptr<H>;
+
+      static constexpr int kMaxEvents = 256;
+      static constexpr std::size_t kReadBufferSize = 64 * 1024;
+      // epoll keys, connections count up from kFirstConnection
+      static constexpr std::uint64_t kWakeKey = 0;
+      static constexpr std::uint64_t kListenKey = 1;
+      static constexpr std::uint64_t kFirstConnection = 2;
+
+      struct Connection {
+        std::shared_ptr<BlockingTcpSocket> conn;
+        handler_ptr handler;
+        std::shared_ptr<TimingWheel::Timer> idle;
+      };
+
+      struct Reactor {
+        int epfd {-1};
+        int wakefd {-1};
+        std::thread thread;
+        std::mutex pendingMutex;
+        std::vector<Connection> pending;
+        // keyed by an id of their own rather than the fd, a handler may close its socket behind the
+        // reactor's back and the kernel hands the number to the next accepted connection
+        std::unordered_map<std::uint64_t, Connection> conns;
+        std::uint64_t nextId {kFirstConnection};
+        TimingWheel wheel;
+      };
+
+    public:
+      EpollTcpServer() : m_workers(std::max(1u, std::thread::hardware_concurrency())) {}
+
+      virtual ~EpollTcpServer() {
+        stop();
+        waitForFinished();
+      }
+
+      void setWorkers(int workers) {
+        if (workers > 0)
+          m_workers = workers;
+      }
+
+      // connections that received nothing for this long are dropped, zero disables it.
+      // has to be set before start()
+      void setIdleTimeout(std::chrono::milliseconds timeout) {
+        m_idleTimeout = timeout;
+      }
+
+      void setNewHandler(std::function<std::shared_ptr<handler_type>()> newHandler)
+      {
+        m_newHandlerCallback = std::move(newHandler);
+      }
+
+      void start(const std::string& address, const std::string& port) {
+        if (!m_reactors.empty())
+          return;
+
+        if (thisptr::net_p::listen(m_listenSock, address.c_str(), port.c_str()) != thisptr::net_p::NETE_Success ||
+            m_listenSock == INVALID_SOCKET)
+        {
+          std::cout << "s : unable to bind to host" << std::endl;
+          return;
+        }
+        thisptr::net_p::setBlocking(m_listenSock, false);
+
+        m_stopRequested = false;
+        for (unsigned int i = 0; i < m_workers; ++i) {
+          std::unique_ptr<Reactor> r(new Reactor);
+          r->epfd = epoll_create1(EPOLL_CLOEXEC);
+          r->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+          if (r->epfd < 0 || r->wakefd < 0 ||
+              !watch(r->epfd, r->wakefd, EPOLLIN, kWakeKey) ||
+              (i == 0 && !watch(r->epfd, (int)m_listenSock, EPOLLIN, kListenKey))) // listener stays level-triggered
+          {
+            std::cerr << "unable to setup epoll reactor: " << thisptr::net_p::lastErrorString() << std::endl;
+            if (r->epfd >= 0) ::close(r->epfd);
+            if (r->wakefd >= 0) ::close(r->wakefd);
+            m_stopRequested = true;
+            break;
+          }
+          m_reactors.push_back(std::move(r));
+        }
+
+        if (m_stopRequested) {
+          waitForFinished();
+          return;
+        }
+
+        for (std::size_t i = 0; i < m_reactors.size(); ++i) {
+          Reactor* r = m_reactors[i].get();
+          r->thread = std::thread(&EpollTcpServer::run, this, r, i == 0);
+        }
+      }
+
+      void stop() {
+        m_stopRequested = true;
+        for (auto& r: m_reactors)
+          wake(*r);
+      }
+
+      void waitForFinished() {
+        for (auto& r: m_reactors) {
+          if (r->thread.joinable())
+            r->thread.join();
+        }
+
+        for (auto& r: m_reactors) {
+          for (auto& c: r->pending)
+            c.conn->close();
+          ::close(r->epfd);
+          ::close(r->wakefd);
+        }
+        m_reactors.clear();
+
+        if (m_listenSock != INVALID_SOCKET) {
+          thisptr::net_p::close(m_listenSock);
+          m_listenSock = INVALID_SOCKET;
+        }
+      }
+
+      std::shared_ptr<handler_type> newHandler()
+      {
+        if (!m_newHandlerCallback)
+        {
+          std::cerr << "you need some initialization for your server!" << std::endl;
+          return nullptr;
+        }
+        return m_newHandlerCallback();
+      }
+
+    protected:
+      static bool watch(int epfd, int fd, uint32_t events, std::uint64_t key) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.u64 = key;
+        return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == 0;
+      }
+
+      static void wake(Reactor& r) {
+        uint64_t one = 1;
+        if (::write(r.wakefd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+          std::cerr << "unable to wake epoll reactor: " << thisptr::net_p::lastErrorString() << std::endl;
+      }
+
+      void run(Reactor* r, bool acceptor) {
+        std::vector<char> buffer(kReadBufferSize);
+        epoll_event events[kMaxEvents];
+
+        while (!m_stopRequested) {
+          // only wake up for the wheel while there are deadlines pending
+          int timeout = r->wheel.empty() ? -1 : (int)r->wheel.tick().count();
+          int n = epoll_wait(r->epfd, events, kMaxEvents, timeout);
+          if (n < 0) {
+            if (errno == EINTR)
+              continue;
+            std::cerr << "epoll wait failed: " << thisptr::net_p::lastErrorString() << std::endl;
+            break;
+          }
+
+          for (int i = 0; i < n && !m_stopRequested; ++i) {
+            std::uint64_t key = events[i].data.u64;
+            if (key == kWakeKey) {
+              uint64_t count;
+              while (::read(r->wakefd, &count, sizeof(count)) > 0);
+              adoptPending(*r);
+            } else if (key == kListenKey) {
+              if (acceptor)
+                acceptAll();
+            } else {
+              onEvent(*r, key, events[i].events, buffer);
+            }
+          }
+
+          r->wheel.advance();
+        }
+
+        while (!r->conns.empty())
+          drop(*r, r->conns.begin()->first);
+      }
+
+      void acceptAll() {
+        while (true) {
+          SOCKET sock = ::accept(m_listenSock, nullptr, nullptr);
+          if (sock == INVALID_SOCKET) {
+            if (errno == EINTR || errno == ECONNABORTED)
+              continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+              std::cerr << "s : unable to accept connection: " << thisptr::net_p::lastErrorString() << std::endl;
+            return;
+          }
+
+          if (m_metrics)
+            m_metrics->add(Metrics::Accepts);
+
+          std::shared_ptr<handler_type> h = newHandler();
+          if (!h)
+          {
+            thisptr::net_p::close(sock);
+            std::cout << "s : cannot accept connection at this time!" << std::endl;
+            continue;
+          }
+
+          auto conn = std::make_shared<BlockingTcpSocket>(sock);
+          conn->setMetrics(m_metrics);
+          Reactor& target = *m_reactors[m_nextReactor++ % m_reactors.size()];
+          {
+            std::lock_guard<std::mutex> lk(target.pendingMutex);
+            target.pending.push_back(Connection{conn, h, nullptr});
+            if (m_metrics)
+              m_metrics->record(Metrics::QueueDepth, target.pending.size());
+          }
+          wake(target);
+        }
+      }
+
+      void adoptPending(Reactor& r) {
+        std::vector<Connection> pending;
+        {
+          std::lock_guard<std::mutex> lk(r.pendingMutex);
+          pending.swap(r.pending);
+        }
+
+        for (auto& c: pending) {
+          std::uint64_t id = r.nextId++;
+          if (!watch(r.epfd, (int)c.conn->handle(), EPOLLIN | EPOLLRDHUP | EPOLLET, id)) {
+            std::cerr << "unable to watch connection: " << thisptr::net_p::lastErrorString() << std::endl;
+            c.conn->close();
+            continue;
+          }
+
+          c.handler->setTcpConn(c.conn);
+          c.handler->setTcpServer(this);
+          if (m_idleTimeout.count() > 0) {
+            c.idle = std::make_shared<TimingWheel::Timer>();
+            Reactor* reactor = &r;
+            r.wheel.arm(*c.idle, m_idleTimeout, [this, reactor, id]() { drop(*reactor, id); });
+          }
+          r.conns.emplace(id, c);
+
+          c.handler->onConnect();
+          if (!c.conn->isOpen())
+            drop(r, id);
+        }
+      }
+
+      void onEvent(Reactor& r, std::uint64_t id, uint32_t events, std::vector<char>& buffer) {
+        auto it = r.conns.find(id);
+        if (it == r.conns.end())
+          return;
+        Connection c = it->second;
+        // closed by its handler from elsewhere, the fd may already belong to someone else
+        if (!c.conn->isOpen()) {
+          drop(r, id);
+          return;
+        }
+        SOCKET sock = c.conn->handle();
+        if (c.idle)
+          r.wheel.rearm(*c.idle, m_idleTimeout);
+
+        bool closed = false;
+        // edge-triggered, so the socket has to be drained until it would block
+        while (!closed) {
+          ssize_t res = ::recv((int)sock, buffer.data(), buffer.size(), MSG_DONTWAIT);
+          if (res > 0) {
+            c.conn->recordRead(res);
+            Metrics::Timer timer(m_metrics, Metrics::HandlerTime);
+            closed = !c.handler->handleData(buffer.data(), res) || !c.conn->isOpen();
+          } else if (res < 0 && errno == EINTR) {
+            continue;
+          } else if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+          } else {
+            closed = true;
+          }
+        }
+
+        if (closed || (events & (EPOLLERR | EPOLLHUP)))
+          drop(r, id);
+      }
+
+      void drop(Reactor& r, std::uint64_t id) {
+        auto it = r.conns.find(id);
+        if (it == r.conns.end())
+          return;
+        Connection c = it->second;
+        r.conns.erase(it);
+        if (c.idle)
+          r.wheel.cancel(*c.idle);
+
+        if (c.conn->isOpen()) {
+          epoll_ctl(r.epfd, EPOLL_CTL_DEL, (int)c.conn->handle(), nullptr);
+          c.conn->close();
+        }
+        c.handler->onDisconnect();
+      }
+
+      unsigned int m_workers;
+      std::vector<std::unique_ptr<Reactor>> m_reactors;
+      std::size_t m_nextReactor {0};
+      std::atomic<bool> m_stopRequested {false};
+      SOCKET m_listenSock {INVALID_SOCKET};
+      std::chrono::milliseconds m_idleTimeout {0};
+
+      std::function<std::shared_ptr<handler_type>()> m_newHandlerCallback;
+    };
+  }
+}
+
+#endif
+
+#endif //NetLib_EPOLLSERVER_H
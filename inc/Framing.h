@@ -0,0 +1,67 @@
+#ifndef NetLib_FRAMING_H
+#define NetLib_FRAMING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace thisptr {
+  namespace net {
+
+    // Length prefixed framing, either a fixed 4 byte big endian length or a LEB128 varint length.
+    class FrameCodec {
+    public:
+      enum class Prefix {
+        Fixed32,
+        Varint
+      };
+
+      static constexpr long long kFrameTooLarge = -1;
+
+      explicit FrameCodec(Prefix prefix = Prefix::Fixed32, std::size_t maxFrameSize = 16 * 1024 * 1024) :
+      m_prefix(prefix), m_maxFrameSize(maxFrameSize) {}
+
+      Prefix prefix() const { return m_prefix; }
+      std::size_t maxFrameSize() const { return m_maxFrameSize; }
+
+      // calls onFrame(const char* frame, std::size_t len) for every complete frame at the front of data,
+      // without copying, until it returns false. returns the number of bytes used up by the delivered frames,
+      // or kFrameTooLarge when a header announces a frame above the max frame size.
+      template <typename F>
+      long long parse(const char* data, std::size_t len, F&& onFrame) const {
+        std::size_t offset = 0;
+        while (offset < len) {
+          std::size_t frameLen = 0;
+          int headerLen = readHeader(data + offset, len - offset, frameLen);
+          if (headerLen < 0)
+            return kFrameTooLarge;
+          if (headerLen == 0 || len - offset - headerLen < frameLen)
+            break;
+
+          offset += headerLen;
+          const char* frame = data + offset;
+          offset += frameLen;
+          if (!onFrame(frame, frameLen))
+            break;
+        }
+        return (long long)offset;
+      }
+
+      // header followed by the payload, ready to be sent
+      std::string frame(const char* data, std::size_t len) const;
+      std::string frame(const std::string& payload) const { return frame(payload.data(), payload.size()); }
+
+      // writes the header for a len byte frame to out (room for 10 bytes), returns the header length
+      std::size_t writeHeader(char* out, std::size_t len) const;
+
+    private:
+      // 0 when the header is not complete yet, -1 when it is malformed or over the limit
+      int readHeader(const char* data, std::size_t len, std::size_t& frameLen) const;
+
+      Prefix m_prefix;
+      std::size_t m_maxFrameSize;
+    };
+  }
+}
+
+#endif //NetLib_FRAMING_H
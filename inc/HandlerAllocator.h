@@ -0,0 +1,101 @@
+#ifndef NetLib_HANDLERALLOCATOR_H
+#define NetLib_HANDLERALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace thisptr {
+  namespace net {
+
+    // Storage for one outstanding asio operation, reused by every operation that is started with it.
+    // Operations that do not fit, or overlap with the one holding the storage, go to the heap.
+    class HandlerMemory {
+    public:
+      HandlerMemory() = default;
+      HandlerMemory(const HandlerMemory&) = delete;
+      HandlerMemory& operator=(const HandlerMemory&) = delete;
+
+      void* allocate(std::size_t size) {
+        if (!m_inUse && size <= sizeof(m_storage)) {
+          m_inUse = true;
+          return &m_storage;
+        }
+        return ::operator new(size);
+      }
+
+      void deallocate(void* pointer) {
+        if (pointer == &m_storage)
+          m_inUse = false;
+        else
+          ::operator delete(pointer);
+      }
+
+    private:
+      typename std::aligned_storage<512>::type m_storage;
+      bool m_inUse {false};
+    };
+
+    template <typename T>
+    class HandlerAllocator {
+    public:
+      using value_type = T;
+
+      explicit HandlerAllocator(HandlerMemory& memory) : m_memory(memory) {}
+
+      template <typename U>
+      HandlerAllocator(const HandlerAllocator<U>& other) noexcept : m_memory(other.m_memory) {}
+
+      bool operator==(const HandlerAllocator& other) const noexcept {
+        return &m_memory == &other.m_memory;
+      }
+
+      bool operator!=(const HandlerAllocator& other) const noexcept {
+        return &m_memory != &other.m_memory;
+      }
+
+      T* allocate(std::size_t n) const {
+        return static_cast<T*>(m_memory.allocate(sizeof(T) * n));
+      }
+
+      void deallocate(T* pointer, std::size_t) const {
+        m_memory.deallocate(pointer);
+      }
+
+    private:
+      template <typename> friend class HandlerAllocator;
+
+      HandlerMemory& m_memory;
+    };
+
+    // completion handler wrapper, asio picks the allocator up through its associated_allocator
+    template <typename Handler>
+    class AllocHandler {
+    public:
+      using allocator_type = HandlerAllocator<Handler>;
+
+      AllocHandler(HandlerMemory& memory, Handler handler) : m_memory(memory), m_handler(std::move(handler)) {}
+
+      allocator_type get_allocator() const noexcept {
+        return allocator_type(m_memory);
+      }
+
+      template <typename ...Args>
+      void operator()(Args&& ...args) {
+        m_handler(std::forward<Args>(args)...);
+      }
+
+    private:
+      HandlerMemory& m_memory;
+      Handler m_handler;
+    };
+
+    template <typename Handler>
+    inline AllocHandler<Handler> makeAllocHandler(HandlerMemory& memory, Handler handler) {
+      return AllocHandler<Handler>(memory, std::move(handler));
+    }
+  }
+}
+
+#endif //NetLib_HANDLERALLOCATOR_H
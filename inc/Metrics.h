@@ -0,0 +1,139 @@
+#ifndef NetLib_METRICS_H
+#define NetLib_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace thisptr {
+  namespace net {
+
+    struct MetricsSnapshot;
+
+    // Process wide or per server counters and distributions. Updates go to one of a fixed set of cache line
+    // aligned shards picked per thread with relaxed atomics, so hot paths never contend on a shared line;
+    // snapshot() sums the shards up.
+    class Metrics {
+    public:
+      enum Counter {
+        Accepts,
+        ActiveConnections, // gauge, incremented on open and decremented on close
+        BytesIn,
+        BytesOut,
+        Reads,
+        Writes,
+        kCounterCount
+      };
+
+      // log2 bucketed distributions
+      enum Distribution {
+        ReadSize,    // bytes per read syscall
+        WriteSize,   // bytes per write
+        QueueDepth,  // pending items seen when queueing a connection or a payload
+        HandlerTime, // ns spent in handler callbacks
+        kDistributionCount
+      };
+
+      static constexpr std::size_t kBuckets = 65; // zero, then one per power of two
+
+      Metrics() = default;
+      Metrics(const Metrics&) = delete;
+      Metrics& operator=(const Metrics&) = delete;
+
+      // sink everything reports to unless told otherwise
+      static Metrics& global();
+
+      void add(Counter counter, std::int64_t value = 1) {
+        shard().counters[counter].fetch_add((std::uint64_t)value, std::memory_order_relaxed);
+      }
+
+      void record(Distribution distribution, std::uint64_t value);
+
+      MetricsSnapshot snapshot() const;
+      void reset();
+
+      static const char* name(Counter counter);
+      static const char* name(Distribution distribution);
+
+      // records the lifetime of the scope into a distribution, does nothing without metrics
+      class Timer {
+      public:
+        Timer(Metrics* metrics, Distribution distribution) : m_metrics(metrics), m_distribution(distribution) {
+          if (m_metrics)
+            m_begin = std::chrono::steady_clock::now();
+        }
+
+        ~Timer() {
+          if (m_metrics)
+            m_metrics->record(m_distribution, (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - m_begin).count());
+        }
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+      private:
+        Metrics* m_metrics;
+        Distribution m_distribution;
+        std::chrono::steady_clock::time_point m_begin;
+      };
+
+    private:
+      static constexpr std::size_t kShards = 32;
+
+      struct alignas(64) Shard {
+        std::atomic<std::uint64_t> counters[kCounterCount] {};
+        std::atomic<std::uint64_t> buckets[kDistributionCount][kBuckets] {};
+        std::atomic<std::uint64_t> sums[kDistributionCount] {};
+        std::atomic<std::uint64_t> maxima[kDistributionCount] {};
+      };
+
+      Shard& shard();
+
+      Shard m_shards[kShards];
+    };
+
+    struct MetricsSnapshot {
+      struct Distribution {
+        std::uint64_t count {0};
+        std::uint64_t sum {0};
+        std::uint64_t max {0};
+        std::array<std::uint64_t, Metrics::kBuckets> buckets {};
+
+        double mean() const { return count ? (double)sum / (double)count : 0.0; }
+        // upper bound of the power of two bucket the percentile (0-100) falls into
+        std::uint64_t percentile(double p) const;
+      };
+
+      std::array<std::int64_t, Metrics::kCounterCount> counters {};
+      std::array<Distribution, Metrics::kDistributionCount> distributions {};
+
+      std::int64_t counter(Metrics::Counter counter) const { return counters[counter]; }
+      const Distribution& distribution(Metrics::Distribution distribution) const { return distributions[distribution]; }
+
+      std::string toJson() const;
+    };
+
+    // per connection totals, readable from any thread while the connection is in use
+    struct ConnectionStats {
+      std::atomic<std::uint64_t> bytesIn {0};
+      std::atomic<std::uint64_t> bytesOut {0};
+      std::atomic<std::uint64_t> reads {0};
+      std::atomic<std::uint64_t> writes {0};
+
+      void onRead(std::size_t len) {
+        bytesIn.fetch_add(len, std::memory_order_relaxed);
+        reads.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      void onWrite(std::size_t len) {
+        bytesOut.fetch_add(len, std::memory_order_relaxed);
+        writes.fetch_add(1, std::memory_order_relaxed);
+      }
+    };
+  }
+}
+
+#endif //NetLib_METRICS_H
@@ -10,13 +10,29 @@
 #include <condition_variable>
 #include <utility>
 #include <deque>
+#include <set>
+#include <algorithm>
+#include <vector>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <cstring>
+#include <stdexcept>
 #include <net_p.h>
 #include <Pool.h>
+#include <BufferPool.h>
+#include <Framing.h>
+#include <Metrics.h>
+#include <TimingWheel.h>
+#include <ZeroCopy.h>
+#include <ConnectionTable.h>
+#include <Resolver.h>
 
 #ifdef WITH_ASIO
 #include <asio.hpp>
 #include <asio/ts/buffer.hpp>
 #include <asio/ts/internet.hpp>
+#include <HandlerAllocator.h>
 #endif
 
 namespace thisptr {
@@ -53,10 +69,47 @@ namespace thisptr {
         return m_sock.send(buf, len);
       }
 
+      int send(std::string&& payload) {
+        return m_sock.send(std::move(payload));
+      }
+
+      long long sendFile(int fd, long long offset, std::size_t length) {
+        return m_sock.sendFile(fd, offset, length);
+      }
+
+      bool setZeroCopyThreshold(std::size_t threshold) {
+        return m_sock.setZeroCopyThreshold(threshold);
+      }
+
+      bool flushZeroCopy(std::chrono::milliseconds timeout) {
+        return m_sock.flushZeroCopy(timeout);
+      }
+
       bool close() {
         return m_sock.close();
       }
 
+      bool shutdown() {
+        return m_sock.shutdown();
+      }
+
+      bool setReadTimeout(std::chrono::milliseconds timeout) {
+        return m_sock.setReadTimeout(timeout);
+      }
+
+      bool setWriteTimeout(std::chrono::milliseconds timeout) {
+        return m_sock.setWriteTimeout(timeout);
+      }
+
+      void setConnectTimeout(std::chrono::milliseconds timeout,
+                             std::chrono::milliseconds attemptDelay = std::chrono::milliseconds(250)) {
+        m_sock.setConnectTimeout(timeout, attemptDelay);
+      }
+
+      void setResolverCache(ResolverCache* resolver) {
+        m_sock.setResolverCache(resolver);
+      }
+
     private:
       socket_type m_sock;
     };
@@ -64,8 +117,20 @@ namespace thisptr {
     template <typename H>
     class AsioTcpSocket;
 
+    // an immutable payload queued on many sockets at once, it is never copied and freed with the last send
+    using SharedBuffer = std::shared_ptr<const std::string>;
+
+    inline SharedBuffer makeSharedBuffer(std::string payload) {
+      return std::make_shared<const std::string>(std::move(payload));
+    }
+
     class AsioContextHolder {
+      using work_guard = asio::executor_work_guard<asio::io_context::executor_type>;
     public:
+      AsioContextHolder() {
+        m_contexts.emplace_back(new asio::io_context());
+      }
+
       virtual ~AsioContextHolder() {
         stop();
       }
@@ -76,8 +141,13 @@ namespace thisptr {
         m_running = true;
 
         try {
-          for (size_t i = 0; i < m_workers; ++i) {
-            asio::post(m_pool, [this] { m_context.run(); });
+          m_pool.reset(new asio::thread_pool(m_workers));
+          // keep run() alive while the sockets are between operations
+          for (auto& context: m_contexts)
+            m_work.emplace_back(asio::make_work_guard(*context));
+          for (size_t i = 0; i < (size_t)m_workers; ++i) {
+            asio::io_context* context = m_contexts[i % m_contexts.size()].get();
+            asio::post(*m_pool, [context] { context->run(); });
           }
           m_waiting = false;
           return true;
@@ -89,34 +159,147 @@ namespace thisptr {
 
       void waitForFinished() {
         m_waiting = true;
-        m_pool.join();
+        if (m_pool)
+          m_pool->join();
       }
 
       void stop() {
         if (!m_running)
           return;
         m_running = false;
-        m_context.stop();
-        if (!m_waiting)
-          m_pool.join();
+        m_work.clear();
+        for (auto& context: m_contexts)
+          context->stop();
+        if (!m_waiting && m_pool)
+          m_pool->join();
+      }
+
+      // runs what a stop left queued, e.g. the completions aborted by closing sockets, so none of them
+      // refers to memory of a socket that is about to be freed. does nothing while running
+      void drain() {
+        if (m_running)
+          return;
+        for (auto& context: m_contexts) {
+          context->restart();
+          context->poll();
+        }
       }
 
       asio::io_context& ctx() {
-        return m_context;
+        return *m_contexts.front();
+      }
+
+      asio::io_context& ctx(std::size_t index) {
+        return *m_contexts[index % m_contexts.size()];
+      }
+
+      // round-robin over the contexts, with a context per worker this spreads connections over the cores
+      asio::io_context& nextCtx() {
+        return *m_contexts[m_nextContext++ % m_contexts.size()];
+      }
+
+      std::size_t contexts() const {
+        return m_contexts.size();
       }
 
       void setWorkers(int workers) {
         m_workers = workers;
+        createContexts();
+      }
+
+      // run one io_context per worker thread instead of all workers on a shared one, has to be set before start
+      void setContextPerWorker(bool contextPerWorker) {
+        m_contextPerWorker = contextPerWorker;
+        createContexts();
       }
 
     private:
+      void createContexts() {
+        std::size_t contexts = m_contextPerWorker ? m_workers : 1;
+        while (m_contexts.size() < contexts)
+          m_contexts.emplace_back(new asio::io_context(1));
+      }
+
       bool m_running {false};
-      asio::io_context m_context;
-      asio::thread_pool m_pool;
+      std::vector<std::unique_ptr<asio::io_context>> m_contexts;
+      std::vector<work_guard> m_work;
+      std::unique_ptr<asio::thread_pool> m_pool;
+      std::atomic<std::size_t> m_nextContext {0};
       int m_workers {1};
+      bool m_contextPerWorker {false};
       bool m_waiting {false};
     };
 
+    // One timing wheel per io_context, advanced by a single steady_timer that only runs while timers are armed.
+    // Sockets sharing a context use it from several threads, so it is guarded by a mutex that is recursive
+    // because timer callbacks may arm timers again.
+    class AsioTimerService: public asio::detail::execution_context_service_base<AsioTimerService> {
+    public:
+      // only ever created through use_service on an io_context, see of()
+      explicit AsioTimerService(asio::execution_context& context) :
+      asio::detail::execution_context_service_base<AsioTimerService>(context),
+      m_ticker(static_cast<asio::io_context&>(context))
+      {}
+
+      template <typename Executor>
+      static AsioTimerService& of(const Executor& executor) {
+        return asio::use_service<AsioTimerService>(asio::query(executor, asio::execution::context));
+      }
+
+      void arm(TimingWheel::Timer& timer, std::chrono::milliseconds timeout, TimingWheel::Callback callback) {
+        std::lock_guard<std::recursive_mutex> lk(m_mutex);
+        m_wheel.arm(timer, timeout, std::move(callback));
+        startTicking();
+      }
+
+      void rearm(TimingWheel::Timer& timer, std::chrono::milliseconds timeout) {
+        std::lock_guard<std::recursive_mutex> lk(m_mutex);
+        m_wheel.rearm(timer, timeout);
+        startTicking();
+      }
+
+      void cancel(TimingWheel::Timer& timer) {
+        std::lock_guard<std::recursive_mutex> lk(m_mutex);
+        m_wheel.cancel(timer);
+      }
+
+      void shutdown() override {
+        std::lock_guard<std::recursive_mutex> lk(m_mutex);
+        m_stopped = true;
+        asio::error_code ec;
+        m_ticker.cancel(ec);
+      }
+
+    private:
+      void startTicking() {
+        if (m_ticking || m_stopped)
+          return;
+        m_ticking = true;
+        tick();
+      }
+
+      void tick() {
+        m_ticker.expires_after(m_wheel.tick());
+        m_ticker.async_wait(makeAllocHandler(m_tickMemory, [this](asio::error_code ec) {
+          std::lock_guard<std::recursive_mutex> lk(m_mutex);
+          if (!ec && !m_stopped)
+            m_wheel.advance();
+          if (ec || m_stopped || m_wheel.empty()) {
+            m_ticking = false;
+            return;
+          }
+          tick();
+        }));
+      }
+
+      std::recursive_mutex m_mutex;
+      TimingWheel m_wheel;
+      asio::steady_timer m_ticker;
+      HandlerMemory m_tickMemory;
+      bool m_ticking {false};
+      bool m_stopped {false};
+    };
+
     template <typename H>
     class Socket<AsioTcpSocket<H>> {
       using socket_type = AsioTcpSocket<H>;
@@ -149,14 +332,59 @@ namespace thisptr {
         return m_sock.recv_until(delimiter);
       }
 
+      int recvFrames(const FrameCodec& codec) {
+        return m_sock.recvFrames(codec);
+      }
+
+      void setIdleTimeout(std::chrono::milliseconds timeout) {
+        m_sock.setIdleTimeout(timeout);
+      }
+
+      void setReadTimeout(std::chrono::milliseconds timeout) {
+        m_sock.setReadTimeout(timeout);
+      }
+
+      void setWriteTimeout(std::chrono::milliseconds timeout) {
+        m_sock.setWriteTimeout(timeout);
+      }
+
+      void setConnectTimeout(std::chrono::milliseconds timeout,
+                             std::chrono::milliseconds attemptDelay = std::chrono::milliseconds(250)) {
+        m_sock.setConnectTimeout(timeout, attemptDelay);
+      }
+
+      void setResolverCache(ResolverCache* resolver) {
+        m_sock.setResolverCache(resolver);
+      }
+
       int send(const std::string& payload) {
         return m_sock.send(payload);
       }
 
+      int send(SharedBuffer payload) {
+        return m_sock.send(std::move(payload));
+      }
+
       int send(const char* buf, int len) {
         return m_sock.send(buf, len);
       }
 
+      int sendFile(int fd, long long offset, std::size_t length) {
+        return m_sock.sendFile(fd, offset, length);
+      }
+
+      void setWriteWatermarks(std::size_t low, std::size_t high) {
+        m_sock.setWriteWatermarks(low, high);
+      }
+
+      bool setZeroCopyThreshold(std::size_t threshold) {
+        return m_sock.setZeroCopyThreshold(threshold);
+      }
+
+      std::size_t pendingBytes() {
+        return m_sock.pendingBytes();
+      }
+
       bool close() {
         return m_sock.close();
       }
@@ -166,37 +394,231 @@ namespace thisptr {
       socket_type m_sock;
     };
 
+    // DynamicBuffer_v1 adapter, lets the asio read algorithms fill a SlabBuffer
+    class SlabDynamicBuffer {
+    public:
+      using const_buffers_type = asio::const_buffer;
+      using mutable_buffers_type = asio::mutable_buffer;
+
+      explicit SlabDynamicBuffer(SlabBuffer& buffer, std::size_t maxSize = (std::numeric_limits<std::size_t>::max)()):
+      m_buffer(buffer), m_maxSize(maxSize)
+      {}
+
+      std::size_t size() const { return m_buffer.size(); }
+      std::size_t max_size() const { return m_maxSize; }
+      std::size_t capacity() const { return m_buffer.capacity(); }
+      const_buffers_type data() const { return {m_buffer.data(), m_buffer.size()}; }
+
+      mutable_buffers_type prepare(std::size_t n) {
+        if (n > m_maxSize - m_buffer.size())
+          throw std::length_error("slab buffer too long");
+        return {m_buffer.prepare(n), n};
+      }
+
+      void commit(std::size_t n) { m_buffer.commit(n); }
+      void consume(std::size_t n) { m_buffer.consume(n); }
+
+    private:
+      SlabBuffer& m_buffer;
+      std::size_t m_maxSize;
+    };
+
+    // buffer sequence referring to a vector owned by the socket, so asio does not copy the vector into its operations
+    class ConstBufferRange {
+    public:
+      using value_type = asio::const_buffer;
+      using const_iterator = std::vector<asio::const_buffer>::const_iterator;
+
+      explicit ConstBufferRange(const std::vector<asio::const_buffer>& buffers) : m_buffers(&buffers) {}
+
+      const_iterator begin() const { return m_buffers->begin(); }
+      const_iterator end() const { return m_buffers->end(); }
+
+    private:
+      const std::vector<asio::const_buffer>* m_buffers;
+    };
+
     template <typename H>
     class AsioTcpSocket {
       using handler_ptr = std::shared_ptr<H>;
+
+      // read or write deadline, see armDeadline
+      struct Deadline {
+        TimingWheel::Timer timer;
+        std::atomic<bool> timedOut {false};
+        std::atomic<unsigned> seq {0};
+        std::atomic<bool> collateral {false};
+      };
+
+      // a queued payload, which may be shared with other sockets, or a file segment when fd is set
+      struct Outgoing {
+        std::string payload;
+        SharedBuffer shared;
+        int fd {-1};
+        long long offset {0};
+        std::size_t length {0};
+        std::size_t sent {0};
+        bool zeroCopied {false};
+        std::uint32_t zeroCopyId {0};
+
+        const std::string& data() const { return shared ? *shared : payload; }
+      };
+
+      // the connect attempts of one connect call, each on its own socket until one of them wins
+      struct ConnectRace {
+        explicit ConnectRace(const asio::ip::tcp::socket::executor_type& executor):
+        resolver(executor), delay(executor), deadline(executor) {}
+
+        std::string host;
+        std::string port;
+        // completions may run on any thread of the context, as may the destructor
+        std::mutex mutex;
+        asio::ip::tcp::resolver resolver;
+        std::vector<asio::ip::tcp::endpoint> endpoints;
+        std::size_t next {0};
+        std::vector<std::unique_ptr<asio::ip::tcp::socket>> attempts;
+        std::size_t inflight {0};
+        asio::steady_timer delay;
+        asio::steady_timer deadline;
+        std::atomic<bool> done {false};
+      };
+
     public:
       explicit AsioTcpSocket(asio::ip::tcp::socket& socket, handler_ptr handler = nullptr):
       m_handler(handler), m_socket(std::move(socket))
-      {}
+      {
+        if (m_socket.is_open())
+          countOpen();
+      }
 
       explicit AsioTcpSocket(asio::io_context& context, handler_ptr handler = nullptr):
       m_handler(handler), m_socket(context)
       {}
 
       ~AsioTcpSocket() {
-        close();
+        if (m_connectRace) {
+          {
+            std::lock_guard<std::mutex> lk(m_connectMutex);
+            m_afterConnect.clear();
+          }
+          finishRace(*m_connectRace, nullptr, false);
+        }
+        if (m_timers) {
+          m_timers->cancel(m_idleTimer);
+          m_timers->cancel(m_readDeadline.timer);
+          m_timers->cancel(m_writeDeadline.timer);
+        }
+#ifdef __linux__
+        retireZeroCopy();
+#endif
+        // nothing may refer to the socket anymore, so close it right away instead of posting it like close()
+        if (m_socket.is_open()) {
+          countClose();
+          if (m_handler)
+            m_handler->onDisconnected(m_socket);
+          asio::error_code ec;
+          m_socket.close(ec);
+        }
       }
 
       void setHandler(handler_ptr handler) {
         m_handler = handler;
       }
 
+      void setBufferPool(BufferPool* pool) {
+        m_buffer.setPool(pool);
+      }
+
+      // where the connection reports to, Metrics::global() by default and nullptr to disable.
+      // has to be set before the connection is used
+      void setMetrics(Metrics* metrics) {
+        bool bCounted = m_counted;
+        countClose();
+        m_metrics = metrics;
+        if (bCounted)
+          countOpen();
+      }
+
+      Metrics* metrics() const { return m_metrics; }
+      const ConnectionStats& stats() const { return m_stats; }
+
+      // deadlines are kept on the timing wheel of the socket's io_context, a zero timeout disables them.
+      // the connection is closed once nothing was read or written for the idle timeout
+      void setIdleTimeout(std::chrono::milliseconds timeout) {
+        m_idleTimeout = timeout;
+        if (timeout.count() > 0)
+          timers().arm(m_idleTimer, timeout, [this]() { close(); });
+        else if (m_timers)
+          m_timers->cancel(m_idleTimer);
+      }
+
+      // a read or write that does not complete in time fails with std::errc::timed_out,
+      // any other operation pending on the socket at that point is aborted as well
+      void setReadTimeout(std::chrono::milliseconds timeout) {
+        m_readTimeout = timeout;
+      }
+
+      void setWriteTimeout(std::chrono::milliseconds timeout) {
+        m_writeTimeout = timeout;
+      }
+
+      // connect gives up after timeout, zero leaves it to the kernel. the resolved addresses are raced
+      // (rfc 8305), the next one is tried attemptDelay after the previous without waiting for it to fail
+      void setConnectTimeout(std::chrono::milliseconds timeout,
+                             std::chrono::milliseconds attemptDelay = std::chrono::milliseconds(250)) {
+        m_connectTimeout = timeout;
+        m_attemptDelay = attemptDelay;
+      }
+
+      // where connect looks names up, ResolverCache::global() by default and nullptr to resolve every time
+      void setResolverCache(ResolverCache* resolver) {
+        m_resolver = resolver;
+      }
+
+      // never blocks, names missing from the cache are resolved asynchronously. reads and writes started
+      // before the connect completed are held back until then, whichever attempt wins
       bool connect(const std::string& address, const std::string& port) {
         try {
-          asio::ip::tcp::resolver resolver(m_socket.get_executor());
-          asio::ip::tcp::resolver::results_type endpoints = resolver.resolve(address, port);
+          auto race = std::make_shared<ConnectRace>(m_socket.get_executor());
+          race->host = address;
+          race->port = port;
 
-          asio::async_connect(m_socket, endpoints, [this](std::error_code ec, asio::ip::tcp::endpoint endpoint){
-            if (ec)
-              std::cerr << "unable to connect to endpoint: " << endpoint.address().to_string() << ", ec: " << ec << std::endl;
-            else
-              m_handler->onConnected(m_socket, endpoint.address().to_string());
-          });
+          {
+            std::lock_guard<std::mutex> lk(m_connectMutex);
+            m_connecting = true;
+            m_connectRace = race;
+          }
+          if (m_connectTimeout.count() > 0) {
+            race->deadline.expires_after(m_connectTimeout);
+            race->deadline.async_wait([this, race](std::error_code ec) {
+              if (!ec && finishRace(*race, nullptr, false))
+                std::cerr << "unable to connect, timed out" << std::endl;
+            });
+          }
+
+          ResolverCache::Entry cached = m_resolver ? m_resolver->find(address, port) : nullptr;
+          if (cached) {
+            asio::post(m_socket.get_executor(), [this, race, cached]() { startRace(race, *cached); });
+          } else {
+            race->resolver.async_resolve(address, port, [this, race](std::error_code ec,
+                                                                     asio::ip::tcp::resolver::results_type results) {
+              if (race->done)
+                return;
+              if (ec) {
+                std::cerr << "unable to resolve " << race->host << ", ec: " << ec << std::endl;
+                finishRace(*race, nullptr, false);
+                return;
+              }
+              auto addresses = std::make_shared<ResolvedAddresses>();
+              for (const auto& entry: results) {
+                asio::ip::tcp::endpoint endpoint = entry.endpoint();
+                addresses->add(endpoint.protocol().family(), SOCK_STREAM, IPPROTO_TCP, endpoint.data(), endpoint.size());
+              }
+              if (m_resolver)
+                m_resolver->store(race->host, race->port, addresses);
+              startRace(race, *addresses);
+            });
+          }
 
         } catch (std::exception& e) {
           std::cerr << "exception occured on asio socket connect" << e.what() << std::endl;
@@ -206,85 +628,238 @@ namespace thisptr {
       }
 
       int recv() {
-        asio::async_read(m_socket, m_buffer,
-                         asio::transfer_at_least(1),
-                         [this](std::error_code ec, std::size_t length){
-                           std::string payload;
-                           {
-                             std::stringstream ss;
-                             ss << &m_buffer;
-                             ss.flush();
-                             payload = ss.str();
-                           }
-                           if (m_handler->onDataReceived(m_socket, ec, payload))
-                             recv();
-                         });
+        if (deferUntilConnected([this]() { recv(); }))
+          return 0;
+        asio::post(m_socket.get_executor(), counted(m_readMemory, [this]() { waitRead(); }));
         return 0;
       }
 
       int recv(unsigned int len) {
+        if (deferUntilConnected([this, len]() { recv(len); }))
+          return 0;
         if (len == 0)
           return 0;
 
-        if (m_buffer.in_avail() >= len)
+        if (m_buffer.size() >= len)
         {
-          asio::post(m_socket.get_executor(), [this, len]() {
-            std::string payload{
-                buffers_begin(m_buffer.data()),
-                buffers_begin(m_buffer.data()) + len};
-            m_buffer.consume(len);
-            m_handler->onDataReceived(m_socket, std::make_error_code(std::errc()), payload);
-          });
+          asio::post(m_socket.get_executor(), counted(m_readMemory, [this, len]() {
+            deliver(std::make_error_code(std::errc()), len);
+          }));
           return 0;
         }
 
-        /*unsigned int lenToRead = len;
-        if (m_buffer.in_avail() > 0)
-          lenToRead -= m_buffer.in_avail();*/
-
-        asio::async_read(m_socket, m_buffer,
-                         asio::transfer_exactly(len),
-                         [this](std::error_code ec, std::size_t length){
-                           std::string payload{
-                               buffers_begin(m_buffer.data()),
-                               buffers_begin(m_buffer.data()) + length};
-                           m_buffer.consume(length);
-                           m_handler->onDataReceived(m_socket, ec, payload);
-                         });
+        armDeadline(m_readDeadline, m_readTimeout);
+        readExactly(len);
         return 0;
       }
 
       int recv_until(const std::string& delimiter) {
-        asio::async_read_until(m_socket, m_buffer, delimiter,
-                               [this, delimiter] (const std::error_code& ec, std::size_t length){
-                                 std::string payload{
-                                     buffers_begin(m_buffer.data()),
-                                     buffers_begin(m_buffer.data()) + length};
-                                 m_buffer.consume(length);
-                                 m_handler->onDataReceived(m_socket, ec, payload);
-        });
+        if (deferUntilConnected([this, delimiter]() { recv_until(delimiter); }))
+          return 0;
+        armDeadline(m_readDeadline, m_readTimeout);
+        readUntil(delimiter);
+        return 0;
+      }
+
+      // keeps reading and hands every complete frame to the handler's onFrame, partial frames stay buffered
+      int recvFrames(const FrameCodec& codec) {
+        m_codec = codec;
+        m_framing = true;
+        return recv();
+      }
+
+#ifdef WITH_COROUTINES
+      struct RecvResult {
+        std::error_code ec;
+        asio::const_buffer data;
+      };
+
+      struct SendResult {
+        std::error_code ec;
+        std::size_t bytes;
+      };
+
+      // coroutine counterpart of recv, e.g. auto [ec, data] = co_await sock.asyncRecv();
+      // data points into the socket buffer and is only valid until the next asyncRecv.
+      // don't mix the coroutine and callback interfaces for the same direction of a socket
+      asio::awaitable<RecvResult> asyncRecv() {
+        co_await connected();
+        m_buffer.consume(m_buffer.size());
+        std::size_t room = m_buffer.capacity();
+        asio::error_code error;
+        std::size_t length;
+        armDeadline(m_readDeadline, m_readTimeout);
+        do {
+          length = co_await m_socket.async_read_some(asio::buffer(m_buffer.prepare(room), room),
+                                                     asio::redirect_error(asio::use_awaitable, error));
+        } while (abortedByOtherDeadline(error, m_readDeadline));
+        std::error_code ec = settleDeadline(m_readDeadline, error);
+        m_buffer.commit(length);
+        recordRead(length);
+        co_return RecvResult{ec, asio::const_buffer(m_buffer.data(), m_buffer.size())};
+      }
+
+      // writes all of payload, which has to stay valid until the coroutine resumes
+      asio::awaitable<SendResult> asyncSend(asio::const_buffer payload) {
+        co_await connected();
+        asio::error_code error;
+        std::size_t length = 0;
+        armDeadline(m_writeDeadline, m_writeTimeout);
+        do {
+          length += co_await asio::async_write(m_socket, payload + length,
+                                               asio::redirect_error(asio::use_awaitable, error));
+        } while (abortedByOtherDeadline(error, m_writeDeadline));
+        std::error_code ec = settleDeadline(m_writeDeadline, error);
+        recordWrite(length);
+        co_return SendResult{ec, length};
+      }
+
+      // resumes once a connect in progress finished, right away otherwise
+      asio::awaitable<void> connected() {
+        if (!m_connecting)
+          co_return;
+        asio::steady_timer wake(m_socket.get_executor(), asio::steady_timer::time_point::max());
+        // expiring instead of cancelling also covers the connect finishing before the wait started
+        if (!deferUntilConnected([&wake]() { wake.expires_at(asio::steady_timer::time_point::min()); }))
+          co_return;
+        asio::error_code error;
+        co_await wake.async_wait(asio::redirect_error(asio::use_awaitable, error));
+      }
+#endif
+
+      // returned by send when the payload was queued but the outbound bytes passed the high watermark
+      static constexpr int kOverWatermark = -2;
+
+      // once more than high bytes are waiting to be written the handler's onWriteBlocked is called and
+      // send returns kOverWatermark, onWritable follows when the backlog drained to low bytes.
+      // payloads are never dropped, producers are expected to pause until then. zero disables it (default)
+      void setWriteWatermarks(std::size_t low, std::size_t high) {
+        std::lock_guard<std::mutex> lk(m_sendMutex);
+        m_highWatermark = high;
+        m_lowWatermark = std::min(low, high);
+      }
+
+      // payloads of at least threshold bytes are written with MSG_ZEROCOPY and held until the kernel released
+      // them, zero disables it (default). set before sending, fails if the os does not support it
+      bool setZeroCopyThreshold(std::size_t threshold) {
+        // the socket is only known once a connect attempt won, it applies to that one
+        if (threshold > 0 && deferUntilConnected([this, threshold]() { setZeroCopyThreshold(threshold); }))
+          return true;
+        if (threshold > 0 && !m_zeroCopyEnabled) {
+          if (thisptr::net_p::enableZeroCopy(m_socket.native_handle()) != 0)
+            return false;
+          m_zeroCopyEnabled = true;
+        }
+        m_zeroCopyThreshold = threshold;
+        return true;
+      }
+
+      std::size_t zeroCopyPending() {
+        std::lock_guard<std::mutex> lk(m_zeroCopyMutex);
+        return m_zeroCopy.size();
+      }
+
+      // bytes queued or being written
+      std::size_t pendingBytes() {
+        std::lock_guard<std::mutex> lk(m_sendMutex);
+        return m_pendingBytes;
+      }
+
+      // payloads are queued and written in order, everything queued while a write is in flight
+      // goes out in one gathered write once it completes. safe to call from any thread.
+      int send(std::string&& payload) {
+        int len = (int)payload.size();
+        Outgoing out;
+        out.payload = std::move(payload);
+        if (enqueue(std::move(out)))
+          return kOverWatermark;
+        return len;
+      }
+
+      // queues length bytes of the file from offset, written in order with the payloads around it straight
+      // from the page cache once the socket is writable. the handler's onFileSent reports the bytes sent,
+      // fd has to stay open until then. file segments do not count towards the write watermarks
+      int sendFile(int fd, long long offset, std::size_t length) {
+        Outgoing out;
+        out.fd = fd;
+        out.offset = offset;
+        out.length = length;
+        enqueue(std::move(out));
         return 0;
       }
 
       int send(const std::string& payload) {
-        asio::async_write(m_socket, asio::buffer(payload),
-                          [this, payload](std::error_code ec, std::size_t length){
-                            m_handler->onDataSent(m_socket, ec, payload);
-                          });
-        return -1;
+        return send(payload.data(), (int)payload.size());
       }
 
+      // queues a reference instead of a copy, meant for sending the same payload to many sockets
+      int send(SharedBuffer payload) {
+        if (!payload)
+          return 0;
+        int len = (int)payload->size();
+        Outgoing out;
+        out.shared = std::move(payload);
+        if (enqueue(std::move(out)))
+          return kOverWatermark;
+        return len;
+      }
+
+      // copies into a string recycled from an earlier send, steady traffic does not allocate
       int send(const char* buf, int len) {
-        return send(std::string(buf, len));
+        std::string payload;
+        {
+          std::lock_guard<std::mutex> lk(m_sendMutex);
+          if (!m_spare.empty()) {
+            payload = std::move(m_spare.back());
+            m_spare.pop_back();
+          }
+        }
+        payload.assign(buf, (std::size_t)len);
+        return send(std::move(payload));
+      }
+
+      bool isOpen() const {
+        return m_socket.is_open();
+      }
+
+      // set by the server that stores this socket in its connection table, it is released there once closed
+      void setOwner(ConnectionOwner* owner, ConnectionId id) {
+        m_owner = owner;
+        m_id = id;
+      }
+
+      ConnectionId id() const { return m_id; }
+
+      // an idle connection is healthy if the peer has neither closed it nor sent anything unexpected
+      bool isHealthy() {
+        if (!m_socket.is_open())
+          return false;
+
+        char c;
+        asio::error_code ec;
+        m_socket.non_blocking(true, ec);
+        m_socket.receive(asio::buffer(&c, 1), asio::socket_base::message_peek, ec);
+        return ec == asio::error::would_block || ec == asio::error::try_again;
       }
 
       bool close() {
         bool bWasOpen;
-        if ((bWasOpen = m_socket.is_open()))
+        if ((bWasOpen = m_socket.is_open())) {
+          m_outstanding++;
           asio::post(m_socket.get_executor(), [this]() {
-            m_socket.close();
+            asio::error_code ec;
+#ifdef __linux__
+            keepZeroCopyHandle();
+#endif
+            m_socket.close(ec);
+            m_closed = true;
+            // the completions the close aborted may run on other threads, the last one to finish releases
+            settle();
           });
+        }
 
+        if (bWasOpen)
+          countClose();
         if (bWasOpen && m_handler)
           m_handler->onDisconnected(m_socket);
 
@@ -292,7 +867,718 @@ namespace thisptr {
       }
 
     private:
-      asio::streambuf m_buffer;
+      void startRace(const std::shared_ptr<ConnectRace>& race, const ResolvedAddresses& addresses) {
+        // alternate the address families, starting with the one the resolver preferred
+        std::vector<asio::ip::tcp::endpoint> preferred, other;
+        for (const struct addrinfo* ptr = addresses.addresses(); ptr != nullptr; ptr = ptr->ai_next) {
+          asio::ip::tcp::endpoint endpoint;
+          std::memcpy(endpoint.data(), ptr->ai_addr, ptr->ai_addrlen);
+          endpoint.resize(ptr->ai_addrlen);
+          (ptr->ai_family == addresses.addresses()->ai_family ? preferred : other).push_back(endpoint);
+        }
+        bool bEmpty;
+        {
+          std::lock_guard<std::mutex> lk(race->mutex);
+          for (std::size_t i = 0; i < preferred.size() || i < other.size(); ++i) {
+            if (i < preferred.size())
+              race->endpoints.push_back(preferred[i]);
+            if (i < other.size())
+              race->endpoints.push_back(other[i]);
+          }
+          bEmpty = race->endpoints.empty();
+        }
+
+        if (bEmpty)
+          finishRace(*race, nullptr, true);
+        else
+          startAttempt(race);
+      }
+
+      // starts the next attempt, and arms the delay after which the one after it starts anyway
+      void startAttempt(const std::shared_ptr<ConnectRace>& race) {
+        std::lock_guard<std::mutex> lk(race->mutex);
+        if (race->done || race->next >= race->endpoints.size())
+          return;
+        asio::ip::tcp::endpoint endpoint = race->endpoints[race->next++];
+        race->attempts.emplace_back(new asio::ip::tcp::socket(m_socket.get_executor()));
+        asio::ip::tcp::socket* attempt = race->attempts.back().get();
+        race->inflight++;
+        attempt->async_connect(endpoint, [this, race, attempt, endpoint](std::error_code ec) {
+          if (!ec) {
+            {
+              std::lock_guard<std::mutex> lk(race->mutex);
+              race->inflight--;
+            }
+            if (!finishRace(*race, attempt, false))
+              return;
+            countOpen();
+            if (m_handler)
+              m_handler->onConnected(m_socket, endpoint.address().to_string());
+            runDeferred();
+            return;
+          }
+
+          bool bNext, bFailed;
+          {
+            std::lock_guard<std::mutex> lk(race->mutex);
+            race->inflight--;
+            if (race->done)
+              return;
+            // nothing left to wait for, move on right away
+            bNext = race->inflight == 0 && race->next < race->endpoints.size();
+            bFailed = race->inflight == 0 && !bNext;
+          }
+          std::cerr << "unable to connect to endpoint: " << endpoint.address().to_string() << ", ec: " << ec << std::endl;
+          if (bNext)
+            startAttempt(race);
+          else if (bFailed)
+            finishRace(*race, nullptr, true);
+        });
+
+        if (race->next < race->endpoints.size()) {
+          race->delay.expires_after(m_attemptDelay);
+          race->delay.async_wait([this, race](std::error_code ec) {
+            if (!ec)
+              startAttempt(race);
+          });
+        }
+      }
+
+      // takes over the winning attempt, if any, and drops the rest. a failed connect leaves the socket closed,
+      // so the held back reads and writes report the failure. false if the race was already over
+      bool finishRace(ConnectRace& race, asio::ip::tcp::socket* winner, bool bAllFailed) {
+        {
+          std::lock_guard<std::mutex> lk(race.mutex);
+          if (race.done.exchange(true))
+            return false;
+          asio::error_code ec;
+          race.resolver.cancel();
+          race.delay.cancel();
+          race.deadline.cancel();
+          for (auto& attempt: race.attempts) {
+            if (attempt.get() == winner)
+              m_socket = std::move(*attempt);
+            else
+              attempt->close(ec);
+          }
+        }
+        // the name may have moved elsewhere, look it up again next time. not on a timeout, nor when the socket
+        // went away first, the addresses may be fine
+        if (bAllFailed && m_resolver)
+          m_resolver->erase(race.host, race.port);
+        if (!winner)
+          runDeferred();
+        return true;
+      }
+
+      // io started while connecting would go to a socket that may lose the race, it runs once connected
+      template <typename F>
+      bool deferUntilConnected(F&& f) {
+        if (!m_connecting.load(std::memory_order_acquire))
+          return false;
+        std::lock_guard<std::mutex> lk(m_connectMutex);
+        if (!m_connecting)
+          return false;
+        m_afterConnect.emplace_back(std::forward<F>(f));
+        return true;
+      }
+
+      void runDeferred() {
+        std::vector<std::function<void()>> deferred;
+        {
+          std::lock_guard<std::mutex> lk(m_connectMutex);
+          m_connecting = false;
+          deferred.swap(m_afterConnect);
+        }
+        for (auto& f: deferred)
+          f();
+      }
+
+      // waits for readability first, so idle connections do not hold a receive slab
+      void waitRead() {
+        armDeadline(m_readDeadline, m_readTimeout);
+        m_socket.async_wait(asio::ip::tcp::socket::wait_read,
+                            counted(m_readMemory, [this](std::error_code ec){
+                              if (abortedByOtherDeadline(ec, m_readDeadline)) {
+                                waitRead();
+                                return;
+                              }
+                              ec = settleDeadline(m_readDeadline, ec);
+                              if (ec) {
+                                deliver(ec, m_buffer.size());
+                                return;
+                              }
+
+                              asio::error_code rec;
+                              std::size_t room = m_buffer.capacity() - m_buffer.size();
+                              if (room == 0) // a partial frame filled the slab, let it grow
+                                room = m_buffer.capacity();
+                              // a handler must not throw, e.g. when the socket was closed meanwhile
+                              m_socket.non_blocking(true, rec);
+                              if (rec) {
+                                deliver(rec, m_buffer.size());
+                                return;
+                              }
+                              std::size_t length = m_socket.read_some(asio::buffer(m_buffer.prepare(room), room), rec);
+                              m_buffer.commit(length);
+                              recordRead(length);
+                              if (rec == asio::error::would_block || rec == asio::error::try_again) {
+                                m_buffer.consume(0);
+                                waitRead();
+                                return;
+                              }
+
+                              if (m_framing ? deliverFrames(rec) : deliver(rec, m_buffer.size()))
+                                waitRead();
+                            }));
+      }
+
+      // only reads what is missing, the rest is already buffered
+      void readExactly(unsigned int len) {
+        asio::async_read(m_socket, SlabDynamicBuffer(m_buffer),
+                         asio::transfer_exactly(len - m_buffer.size()),
+                         counted(m_readMemory, [this, len](std::error_code ec, std::size_t length){
+                           recordRead(length);
+                           if (abortedByOtherDeadline(ec, m_readDeadline)) {
+                             readExactly(len);
+                             return;
+                           }
+                           ec = settleDeadline(m_readDeadline, ec);
+                           deliver(ec, std::min<std::size_t>(len, m_buffer.size()));
+                         }));
+      }
+
+      void readUntil(const std::string& delimiter) {
+        asio::async_read_until(m_socket, SlabDynamicBuffer(m_buffer), delimiter,
+                               counted(m_readMemory, [this, delimiter] (std::error_code ec, std::size_t length){
+                                 if (abortedByOtherDeadline(ec, m_readDeadline)) {
+                                   readUntil(delimiter);
+                                   return;
+                                 }
+                                 ec = settleDeadline(m_readDeadline, ec);
+                                 recordRead(length);
+                                 deliver(ec, length);
+        }));
+      }
+
+      // hands the first len buffered bytes to the handler without copying them, they are consumed afterwards
+      bool deliver(std::error_code ec, std::size_t len) {
+        asio::const_buffer view(m_buffer.data(), len);
+        bool bRes;
+        {
+          Metrics::Timer timer(m_metrics, Metrics::HandlerTime);
+          bRes = m_handler->onBufferReceived(m_socket, ec, view);
+        }
+        m_buffer.consume(len);
+        // nobody else would close a failed connection the server owns
+        if (ec && m_owner)
+          close();
+        return bRes;
+      }
+
+      // hands every complete buffered frame to the handler without copying, stops early if the handler returns false
+      bool deliverFrames(std::error_code ec) {
+        if (ec)
+          return deliver(ec, m_buffer.size());
+
+        bool bRes = true;
+        Metrics::Timer timer(m_metrics, Metrics::HandlerTime);
+        long long used = m_codec.parse(m_buffer.data(), m_buffer.size(), [this, &bRes](const char* frame, std::size_t len) {
+          return bRes = m_handler->onFrame(m_socket, asio::const_buffer(frame, len));
+        });
+        if (used == FrameCodec::kFrameTooLarge) {
+          deliver(std::make_error_code(std::errc::message_size), 0);
+          return false;
+        }
+
+        m_buffer.consume((std::size_t)used);
+        return bRes;
+      }
+
+      // returns true if the backlog is over the high watermark
+      bool enqueue(Outgoing&& out) {
+        bool bStartWrite, bBlocked = false, bOver;
+        std::size_t pending;
+        {
+          std::lock_guard<std::mutex> lk(m_sendMutex);
+          m_pendingBytes += out.data().size();
+          if (out.fd >= 0)
+            m_queuedFiles++;
+          m_outbox.push_back(std::move(out));
+          bStartWrite = !m_writing;
+          m_writing = true;
+          pending = m_pendingBytes;
+          bOver = m_highWatermark > 0 && pending > m_highWatermark;
+          if (bOver && !m_writeBlocked)
+            bBlocked = m_writeBlocked = true;
+          if (m_metrics)
+            m_metrics->record(Metrics::QueueDepth, m_outbox.size());
+        }
+
+        if (bBlocked)
+          m_handler->onWriteBlocked(m_socket, pending);
+        if (bStartWrite && !deferUntilConnected([this]() { write(); }))
+          asio::post(m_socket.get_executor(), counted(m_writeMemory, [this]() { write(); }));
+        return bOver;
+      }
+
+      void write() {
+        {
+          // a file segment goes out on its own, the payloads queued up to the next one are gathered
+          std::lock_guard<std::mutex> lk(m_sendMutex);
+          if (m_queuedFiles == 0) {
+            std::swap(m_inflight, m_outbox);
+          } else {
+            do {
+              m_inflight.push_back(std::move(m_outbox.front()));
+              m_outbox.pop_front();
+            } while (m_inflight.front().fd < 0 && !m_outbox.empty() && m_outbox.front().fd < 0);
+            if (m_inflight.front().fd >= 0)
+              m_queuedFiles--;
+          }
+        }
+
+        armDeadline(m_writeDeadline, m_writeTimeout);
+        if (m_inflight.front().fd >= 0) {
+          writeFile();
+          return;
+        }
+#ifdef __linux__
+        if (m_zeroCopyThreshold > 0) {
+          for (auto& out: m_inflight) {
+            if (out.data().size() >= m_zeroCopyThreshold) {
+              writeZeroCopy();
+              return;
+            }
+          }
+        }
+#endif
+
+        writeGathered();
+      }
+
+      // gathers what is left of the batch into one write
+      void writeGathered() {
+        m_writeBuffers.clear();
+        for (auto& out: m_inflight) {
+          if (out.sent < out.data().size())
+            m_writeBuffers.emplace_back(asio::buffer(out.data()) + out.sent);
+        }
+
+        asio::async_write(m_socket, ConstBufferRange(m_writeBuffers),
+                          counted(m_writeMemory, [this](std::error_code ec, std::size_t length){
+                            recordWrite(length);
+                            if (abortedByOtherDeadline(ec, m_writeDeadline)) {
+                              for (auto& out: m_inflight) {
+                                std::size_t part = std::min(length, out.data().size() - out.sent);
+                                out.sent += part;
+                                length -= part;
+                              }
+                              writeGathered();
+                              return;
+                            }
+                            ec = settleDeadline(m_writeDeadline, ec);
+                            written(ec);
+                          }));
+      }
+
+      // sendfile on the non-blocking socket whenever it becomes writable, until the segment is out
+      void writeFile() {
+        m_socket.async_wait(asio::ip::tcp::socket::wait_write,
+                            counted(m_writeMemory, [this](std::error_code ec){
+                              if (abortedByOtherDeadline(ec, m_writeDeadline)) {
+                                writeFile();
+                                return;
+                              }
+                              Outgoing& out = m_inflight.front();
+                              if (!ec)
+                                ec = setNativeNonBlocking();
+                              while (!ec && out.sent < out.length) {
+                                long long res = thisptr::net_p::sendFile(m_socket.native_handle(), out.fd,
+                                                                         out.offset + (long long)out.sent,
+                                                                         out.length - out.sent);
+                                if (res < 0) {
+                                  if (errno == EINTR)
+                                    continue;
+                                  if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                                    writeFile();
+                                    return;
+                                  }
+                                  ec = std::error_code(errno, std::system_category());
+                                } else if (res == 0) {
+                                  ec = std::make_error_code(std::errc::io_error); // the file ended early
+                                } else {
+                                  recordWrite((std::size_t)res);
+                                  out.sent += (std::size_t)res;
+                                }
+                              }
+                              ec = settleDeadline(m_writeDeadline, ec);
+                              written(ec);
+                            }));
+      }
+
+#ifdef __linux__
+      // writes the batch on the non-blocking socket, the large payloads with MSG_ZEROCOPY
+      void writeZeroCopy() {
+        m_socket.async_wait(asio::ip::tcp::socket::wait_write,
+                            counted(m_writeMemory, [this](std::error_code ec){
+                              if (abortedByOtherDeadline(ec, m_writeDeadline)) {
+                                writeZeroCopy();
+                                return;
+                              }
+                              if (!ec)
+                                ec = setNativeNonBlocking();
+                              int sock = (int)m_socket.native_handle();
+                              for (auto& out: m_inflight) {
+                                const std::string& payload = out.data();
+                                bool bZeroCopy = payload.size() >= m_zeroCopyThreshold;
+                                while (!ec && out.sent < payload.size()) {
+                                  const char* data = payload.data() + out.sent;
+                                  int len = (int)(payload.size() - out.sent);
+                                  int res = bZeroCopy ? thisptr::net_p::sendZeroCopy(sock, data, len) : -1;
+                                  if (res > 0) {
+                                    std::lock_guard<std::mutex> lk(m_zeroCopyMutex);
+                                    out.zeroCopied = true;
+                                    out.zeroCopyId = m_zeroCopy.nextId();
+                                  } else if (!bZeroCopy || (res < 0 && errno == ENOBUFS)) {
+                                    // small payload, or no room left for more notifications
+                                    res = (int)::send(sock, data, (std::size_t)len, MSG_NOSIGNAL);
+                                  }
+
+                                  if (res < 0) {
+                                    if (errno == EINTR)
+                                      continue;
+                                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                                      writeZeroCopy();
+                                      return;
+                                    }
+                                    ec = std::error_code(errno, std::system_category());
+                                    break;
+                                  }
+                                  recordWrite((std::size_t)res);
+                                  out.sent += (std::size_t)res;
+                                }
+                              }
+                              ec = settleDeadline(m_writeDeadline, ec);
+                              written(ec);
+                            }));
+      }
+
+      // completions arrive on the socket error queue, which asio reports as an error condition
+      void waitZeroCopy() {
+        m_socket.async_wait(asio::ip::tcp::socket::wait_error,
+                            counted(m_zeroCopyMemory, [this](std::error_code ec){
+                              std::lock_guard<std::mutex> lk(m_zeroCopyMutex);
+                              if (!ec)
+                                m_zeroCopy.reap(m_socket.native_handle());
+                              if (ec || m_zeroCopy.empty()) {
+                                m_zeroCopyWaiting = false;
+                                return;
+                              }
+                              waitZeroCopy();
+                            }));
+      }
+
+      // the kernel may still read from the held payloads, so they outlive the socket (see ZeroCopyTracker::retire).
+      // a write the close aborted may hold more afterwards, those are read off the handle kept for it
+      void retireZeroCopy() {
+        std::lock_guard<std::mutex> lk(m_zeroCopyMutex);
+        int sock = m_socket.is_open() ? (int)m_socket.native_handle() : m_zeroCopyHandle;
+        if (sock >= 0 && !m_zeroCopy.empty()) {
+          m_zeroCopy.reap(sock);
+          if (!m_zeroCopy.empty() && !ZeroCopyTracker::retire(sock, std::move(m_zeroCopy))) {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+            while (m_zeroCopy.reap(sock) >= 0 && !m_zeroCopy.empty()) {
+              auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+              if (left.count() <= 0 || thisptr::net_p::waitZeroCopy(sock, (int)left.count()) < 0)
+                break;
+            }
+          }
+          m_zeroCopy = ZeroCopyTracker();
+        }
+        if (m_zeroCopyHandle >= 0) {
+          ::close(m_zeroCopyHandle);
+          m_zeroCopyHandle = -1;
+        }
+      }
+
+      // retires what is held before close, and keeps a duplicate of the socket while a write is in flight
+      void keepZeroCopyHandle() {
+        retireZeroCopy();
+        if (!m_zeroCopyEnabled)
+          return;
+        {
+          std::lock_guard<std::mutex> lk(m_sendMutex);
+          if (!m_writing)
+            return;
+        }
+        std::lock_guard<std::mutex> lk(m_zeroCopyMutex);
+        m_zeroCopyHandle = ::dup((int)m_socket.native_handle());
+        // the duplicate keeps the connection from closing, so end it for the peer here
+        if (m_zeroCopyHandle >= 0)
+          ::shutdown((int)m_socket.native_handle(), SHUT_RDWR);
+      }
+#endif
+
+      std::error_code setNativeNonBlocking() {
+        if (m_socket.native_non_blocking())
+          return {};
+        asio::error_code error;
+        m_socket.native_non_blocking(true, error);
+        if (error)
+          return std::error_code(error.value(), std::system_category());
+        return {};
+      }
+
+      // completes everything in flight and moves on to what was queued meanwhile
+      void written(std::error_code ec) {
+        std::size_t bytes = 0;
+        bool bHeld = false;
+        for (auto& out: m_inflight) {
+          bytes += out.data().size();
+          notifySent(out, ec);
+          if (out.zeroCopied) {
+            // the kernel may still read from it
+            std::lock_guard<std::mutex> lk(m_zeroCopyMutex);
+            if (out.shared)
+              m_zeroCopy.hold(out.zeroCopyId, std::move(out.shared));
+            else
+              m_zeroCopy.hold(out.zeroCopyId, std::move(out.payload));
+            bHeld = true;
+          }
+        }
+#ifdef __linux__
+        if (bHeld) {
+          std::lock_guard<std::mutex> lk(m_zeroCopyMutex);
+          m_zeroCopy.reap(m_socket.native_handle());
+          if (!m_zeroCopy.empty() && !m_zeroCopyWaiting) {
+            m_zeroCopyWaiting = true;
+            waitZeroCopy();
+          }
+        }
+#endif
+
+        bool bWritable = false, bIdle = false;
+        {
+          std::lock_guard<std::mutex> lk(m_sendMutex);
+          recycle();
+          if (ec) {
+            // the socket is unusable, report what is still queued as failed as well
+            std::swap(m_inflight, m_outbox);
+            m_pendingBytes = 0;
+            m_queuedFiles = 0;
+            if (m_inflight.empty())
+              m_writing = false;
+          } else {
+            m_pendingBytes -= bytes;
+            if (m_writeBlocked && m_pendingBytes <= m_lowWatermark) {
+              m_writeBlocked = false;
+              bWritable = true;
+            }
+            bIdle = m_outbox.empty();
+            if (bIdle)
+              m_writing = false;
+          }
+        }
+
+        // may queue more, which restarts writing if this completion already went idle
+        if (bWritable)
+          m_handler->onWritable(m_socket);
+        if (bIdle)
+          return;
+
+        if (ec) {
+          // enqueue starts no write while m_writing is set, so fail whatever it queued meanwhile
+          // and only clear the flag under the lock that saw the outbox empty
+          while (!m_inflight.empty()) {
+            for (auto& out: m_inflight)
+              notifySent(out, ec);
+            m_inflight.clear();
+            std::lock_guard<std::mutex> lk(m_sendMutex);
+            std::swap(m_inflight, m_outbox);
+            m_pendingBytes = 0;
+            m_queuedFiles = 0;
+            if (m_inflight.empty())
+              m_writing = false;
+          }
+          return;
+        }
+        write();
+      }
+
+      // keeps the written payload strings for the next sends and empties m_inflight, called under m_sendMutex
+      void recycle() {
+        if (m_spare.capacity() == 0)
+          m_spare.reserve(kSpareStrings);
+        for (auto& out: m_inflight) {
+          if (m_spare.size() == kSpareStrings)
+            break;
+          if (out.payload.capacity() > 0 && out.payload.capacity() <= kSpareCapacity)
+            m_spare.push_back(std::move(out.payload));
+        }
+        m_inflight.clear();
+      }
+
+      void notifySent(const Outgoing& out, std::error_code ec) {
+        if (out.fd >= 0)
+          m_handler->onFileSent(m_socket, ec, out.fd, out.sent);
+        else
+          m_handler->onDataSent(m_socket, ec, out.data());
+      }
+
+      AsioTimerService& timers() {
+        if (!m_timers)
+          m_timers = &AsioTimerService::of(m_socket.get_executor());
+        return *m_timers;
+      }
+
+      // sockets only cancel all their operations at once, so the expired deadline marks the other direction's
+      // operation, which is issued again (see abortedByOtherDeadline). the tag keeps a late cancel off the next operation
+      void armDeadline(Deadline& deadline, std::chrono::milliseconds timeout) {
+        deadline.collateral = false;
+        if (timeout.count() <= 0)
+          return;
+        deadline.timedOut = false;
+        unsigned tag = ++deadline.seq;
+        timers().arm(deadline.timer, timeout, [this, &deadline, tag]() {
+          if (deadline.seq != tag)
+            return;
+          deadline.timedOut = true;
+          m_outstanding++;
+          asio::post(m_socket.get_executor(), [this, &deadline, tag]() {
+            // unless the operation completed meanwhile, or a newer one was started
+            if (deadline.timedOut && deadline.seq == tag) {
+              (&deadline == &m_readDeadline ? m_writeDeadline : m_readDeadline).collateral = true;
+              asio::error_code ec;
+              m_socket.cancel(ec);
+            }
+            settle();
+          });
+        });
+      }
+
+      // completion handler that keeps the socket alive: an adopted socket is only released once it is closed
+      // and every handler started on it ran, including the ones the close aborted
+      template <typename Handler>
+      auto counted(HandlerMemory& memory, Handler handler) {
+        m_outstanding++;
+        return makeAllocHandler(memory, [this, handler = std::move(handler)](auto&& ...args) mutable {
+          handler(std::forward<decltype(args)>(args)...);
+          settle();
+        });
+      }
+
+      // nothing may touch the socket after this, the owner may have freed it
+      void settle() {
+        if (--m_outstanding == 0 && m_closed && m_owner && !m_released.exchange(true))
+          m_owner->release(m_id);
+      }
+
+      // the operation was only aborted because the other direction's deadline expired
+      bool abortedByOtherDeadline(std::error_code ec, Deadline& deadline) {
+        return deadline.collateral.exchange(false) && ec == std::errc::operation_canceled && m_socket.is_open();
+      }
+
+      // stops the deadline of a completed operation, reports timed_out if it was the deadline that ended it
+      std::error_code settleDeadline(Deadline& deadline, std::error_code ec) {
+        if (m_timers)
+          m_timers->cancel(deadline.timer);
+        if (deadline.timedOut.exchange(false) && ec)
+          ec = std::make_error_code(std::errc::timed_out);
+        if (!ec && m_idleTimeout.count() > 0)
+          m_timers->rearm(m_idleTimer, m_idleTimeout);
+        return ec;
+      }
+
+      void recordRead(std::size_t len) {
+        if (len == 0)
+          return;
+        m_stats.onRead(len);
+        if (!m_metrics)
+          return;
+        m_metrics->add(Metrics::Reads);
+        m_metrics->add(Metrics::BytesIn, (std::int64_t)len);
+        m_metrics->record(Metrics::ReadSize, len);
+      }
+
+      void recordWrite(std::size_t len) {
+        if (len == 0)
+          return;
+        m_stats.onWrite(len);
+        if (!m_metrics)
+          return;
+        m_metrics->add(Metrics::Writes);
+        m_metrics->add(Metrics::BytesOut, (std::int64_t)len);
+        m_metrics->record(Metrics::WriteSize, len);
+      }
+
+      void countOpen() {
+        if (!m_counted.exchange(true) && m_metrics)
+          m_metrics->add(Metrics::ActiveConnections);
+      }
+
+      void countClose() {
+        if (m_counted.exchange(false) && m_metrics)
+          m_metrics->add(Metrics::ActiveConnections, -1);
+      }
+
+      SlabBuffer m_buffer;
+      FrameCodec m_codec;
+      bool m_framing {false};
+
+      std::mutex m_sendMutex;
+      std::deque<Outgoing> m_outbox;
+      std::deque<Outgoing> m_inflight;
+      std::size_t m_queuedFiles {0};
+      static constexpr std::size_t kSpareStrings = 16;
+      static constexpr std::size_t kSpareCapacity = 64 * 1024;
+      std::vector<std::string> m_spare;
+
+      std::mutex m_zeroCopyMutex;
+      ZeroCopyTracker m_zeroCopy;
+      std::size_t m_zeroCopyThreshold {0};
+      bool m_zeroCopyEnabled {false};
+      bool m_zeroCopyWaiting {false};
+      // duplicate of a closed socket, see keepZeroCopyHandle
+      int m_zeroCopyHandle {-1};
+      std::vector<asio::const_buffer> m_writeBuffers;
+      bool m_writing {false};
+      std::size_t m_pendingBytes {0};
+      std::size_t m_lowWatermark {0};
+      std::size_t m_highWatermark {0};
+      bool m_writeBlocked {false};
+
+      // at most one read and one write are outstanding per socket, their operations reuse this storage
+      HandlerMemory m_readMemory;
+      HandlerMemory m_writeMemory;
+      HandlerMemory m_zeroCopyMemory;
+
+      Metrics* m_metrics {&Metrics::global()};
+      ConnectionStats m_stats;
+      std::atomic<bool> m_counted {false};
+
+      ConnectionOwner* m_owner {nullptr};
+      ConnectionId m_id {kInvalidConnection};
+      std::atomic<int> m_outstanding {0};
+      std::atomic<bool> m_closed {false};
+      std::atomic<bool> m_released {false};
+
+      AsioTimerService* m_timers {nullptr};
+      TimingWheel::Timer m_idleTimer;
+      std::chrono::milliseconds m_idleTimeout {0};
+      std::chrono::milliseconds m_readTimeout {0};
+      std::chrono::milliseconds m_writeTimeout {0};
+      Deadline m_readDeadline;
+      Deadline m_writeDeadline;
+
+      std::chrono::milliseconds m_connectTimeout {0};
+      std::chrono::milliseconds m_attemptDelay {250};
+      std::mutex m_connectMutex;
+      std::atomic<bool> m_connecting {false};
+      std::vector<std::function<void()>> m_afterConnect;
+      std::shared_ptr<ConnectRace> m_connectRace;
+      ResolverCache* m_resolver {&ResolverCache::global()};
 
       asio::ip::tcp::socket m_socket;
       handler_ptr m_handler;
@@ -309,12 +1595,69 @@ namespace thisptr {
       std::shared_ptr<BlockingTcpSocket> accept();
 
       int recv(char* buf, int len);
-      int send(const char* buf);
-      int send(const char* buf, int len);
+      int waitReadable();
+      virtual int send(const char* buf);
+      virtual int send(const char* buf, int len);
+      // sends length bytes of the file from offset straight from the page cache,
+      // returns the bytes sent (fewer if the file is shorter) or an error after closing the socket
+      virtual long long sendFile(int fd, long long offset, std::size_t length);
+      // payloads of at least threshold bytes go out with MSG_ZEROCOPY and are kept until the kernel released
+      // them, smaller ones are copied as usual. zero disables it (default), fails if the os does not support it
+      bool setZeroCopyThreshold(std::size_t threshold);
+      virtual int send(std::string&& payload);
+      // waits until the kernel released every zero-copy payload or the timeout passed. close does not wait,
+      // the payloads still held are kept past it (see ZeroCopyTracker::retire)
+      bool flushZeroCopy(std::chrono::milliseconds timeout);
+      const ZeroCopyTracker& zeroCopy() const { return m_zeroCopy; }
       bool close();
+      // ends both directions so a thread blocked on the socket returns, closing is still up to the owner
+      bool shutdown();
+
+      bool isOpen() const { return m_sock != INVALID_SOCKET; }
+      // an idle connection is healthy if the peer has neither closed it nor sent anything unexpected
+      bool isHealthy();
+      unsigned long long handle() const { return m_sock; }
+
+      // a blocked thread already waits in the kernel, so deadlines are plain socket timeouts here.
+      // recv and waitReadable return NETE_Timedout once the read timeout passes, zero disables it
+      bool setReadTimeout(std::chrono::milliseconds timeout);
+      bool setWriteTimeout(std::chrono::milliseconds timeout);
+      // connect gives up after timeout, zero leaves it to the kernel. the resolved addresses are raced,
+      // the next one is tried attemptDelay after the previous without waiting for it to fail
+      void setConnectTimeout(std::chrono::milliseconds timeout,
+                             std::chrono::milliseconds attemptDelay = std::chrono::milliseconds(250)) {
+        m_connectTimeout = timeout;
+        m_attemptDelay = attemptDelay;
+      }
+
+      // where connect looks names up, ResolverCache::global() by default and nullptr to resolve every time
+      void setResolverCache(ResolverCache* resolver) { m_resolver = resolver; }
+
+      // where the connection reports to, Metrics::global() by default and nullptr to disable
+      void setMetrics(Metrics* metrics);
+      Metrics* metrics() const { return m_metrics; }
+      const ConnectionStats& stats() const { return m_stats; }
+
+      // accounting for reads and writes done on the handle directly, e.g. by a reactor
+      void recordRead(std::size_t len);
+      void recordWrite(std::size_t len);
 
     protected:
+      void countOpen();
+      void countClose();
+      void retireZeroCopy();
+
       unsigned long long m_sock;
+      Metrics* m_metrics {&Metrics::global()};
+      ConnectionStats m_stats;
+      bool m_counted {false};
+      bool m_readTimeout {false};
+      std::chrono::milliseconds m_connectTimeout {0};
+      std::chrono::milliseconds m_attemptDelay {250};
+      ResolverCache* m_resolver {&ResolverCache::global()};
+      std::size_t m_zeroCopyThreshold {0};
+      bool m_zeroCopyEnabled {false};
+      ZeroCopyTracker m_zeroCopy;
     };
 
     template <typename S>
@@ -325,7 +1668,15 @@ namespace thisptr {
       virtual ~TcpClient() = default;
     };
 
-    class TcpServerBase {};
+    class TcpServerBase {
+    public:
+      // where the server and its connections report to, Metrics::global() by default and nullptr to disable
+      void setMetrics(Metrics* metrics) { m_metrics = metrics; }
+      Metrics* metrics() const { return m_metrics; }
+
+    protected:
+      Metrics* m_metrics {&Metrics::global()};
+    };
 
     template <typename S>
     class AsyncConnectionHandlerBase {
@@ -335,10 +1686,48 @@ namespace thisptr {
       virtual void onDisconnected(asio::ip::tcp::socket& sock) {}
       virtual void onServerDisconnected() {}
       virtual bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) = 0;
+      // zero-copy receive hook, payload points into the socket buffer and is only valid until this returns
+      virtual bool onBufferReceived(asio::ip::tcp::socket& sock, std::error_code ec, asio::const_buffer payload) {
+        return onDataReceived(sock, ec, std::string(static_cast<const char*>(payload.data()), payload.size()));
+      }
       virtual void onDataSent(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) = 0;
+      // a segment queued with sendFile went out, sent is less than requested on error
+      virtual void onFileSent(asio::ip::tcp::socket& sock, std::error_code ec, int fd, std::size_t sent) {}
+      // the socket's outbound backlog passed its high watermark, stop sending until onWritable
+      virtual void onWriteBlocked(asio::ip::tcp::socket& sock, std::size_t pending) {}
+      // the backlog drained to the low watermark after onWriteBlocked, called from the write completion
+      virtual void onWritable(asio::ip::tcp::socket& sock) {}
+      // called for every complete frame when reading with recvFrames, frame is only valid until this returns
+      virtual bool onFrame(asio::ip::tcp::socket& sock, asio::const_buffer frame) { return true; }
       virtual void onNewConnection(asio::ip::tcp::socket& sock) {}
     };
 
+    // static alternative to AsyncConnectionHandlerBase: H derives from StaticConnectionHandlerBase<H> and declares
+    // the hooks it needs without virtual, hiding these defaults. AsioTcpSocket<H> and AsyncTcpServer<H> call them
+    // on H directly, so they can be inlined. (a virtual handler marked final gets most of that as well)
+    template <typename H>
+    class StaticConnectionHandlerBase {
+    public:
+      void onConnected(asio::ip::tcp::socket& sock, const std::string& endpoint) {}
+      void onDisconnected(asio::ip::tcp::socket& sock) {}
+      void onServerDisconnected() {}
+      bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) { return !ec; }
+      bool onBufferReceived(asio::ip::tcp::socket& sock, std::error_code ec, asio::const_buffer payload) {
+        return self().onDataReceived(sock, ec, std::string(static_cast<const char*>(payload.data()), payload.size()));
+      }
+      void onDataSent(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) {}
+      void onFileSent(asio::ip::tcp::socket& sock, std::error_code ec, int fd, std::size_t sent) {}
+      void onWriteBlocked(asio::ip::tcp::socket& sock, std::size_t pending) {}
+      void onWritable(asio::ip::tcp::socket& sock) {}
+      bool onFrame(asio::ip::tcp::socket& sock, asio::const_buffer frame) { return true; }
+      void onNewConnection(asio::ip::tcp::socket& sock) {}
+
+    protected:
+      ~StaticConnectionHandlerBase() = default;
+
+      H& self() { return static_cast<H&>(*this); }
+    };
+
     class BlockingTcpHandler {
     public:
       void operator() ();
@@ -346,12 +1735,22 @@ namespace thisptr {
       virtual void onConnect();
       virtual void onDisconnect();
       virtual void onMessage(std::string data);
+      // called for every complete frame once a frame codec is set, data is only valid until this returns
+      virtual void onFrame(const char* data, std::size_t len);
+
+      // received data is split into frames and delivered through onFrame instead of onMessage
+      void setFrameCodec(const FrameCodec& codec);
+      // hands received data to onMessage or onFrame, returns false if the stream is malformed
+      bool handleData(const char* data, std::size_t len);
 
       void setTcpServer(TcpServerBase* server);
       void setTcpConn(std::shared_ptr<net::BlockingTcpSocket>& conn);
     protected:
       TcpServerBase* m_server {};
       std::shared_ptr<net::BlockingTcpSocket> m_conn{};
+      FrameCodec m_codec;
+      bool m_framing {false};
+      std::string m_partial; // incomplete frame left over from the last read
     };
 
     template <typename S, typename H>
@@ -362,10 +1761,20 @@ namespace thisptr {
       TcpServer() = default;
 
       virtual ~TcpServer() {
+        stop();
         if (m_stopThread.joinable())
           m_stopThread.join();
         if (m_serverThread.joinable())
           m_serverThread.join();
+        for (auto& worker: m_workers) {
+          if (worker.joinable())
+            worker.join();
+        }
+        // idle pooled handlers go to the remove callback while it is still around
+        m_handlerPool.reset();
+        // connection threads of the thread-per-connection mode are detached but still use the server
+        std::unique_lock<std::mutex> lk(m_activeMutex);
+        m_activeCv.wait(lk, [=]{ return m_active.empty(); });
       }
 
       bool bind(const std::string& address, const std::string& port) {
@@ -378,7 +1787,33 @@ namespace thisptr {
         return m_sock.accept();
       }
 
+      // Serve accepted connections from a fixed number of worker threads instead of a thread per connection.
+      // Connections are queued up to maxPending, the accept loop refuses new ones while the queue is full.
+      // Handlers from setNewHandler are pooled up to workers + maxPending and reused between connections,
+      // setResetHandler clears a handler's state before reuse and setRemoveHandler gets it once it leaves the pool.
+      void setWorkerPool(unsigned int workers = std::thread::hardware_concurrency(), std::size_t maxPending = 128) {
+        if (!m_workers.empty())
+          return;
+        m_workerCount = workers > 0 ? workers : 1;
+        m_maxPending = maxPending;
+      }
+
       void start(const std::string& address, const std::string& port) {
+        if (m_workerCount > 0) {
+          m_handlerPool.reset(new thisptr::utils::Pool<std::shared_ptr<handler_type>>(
+              [this]() -> std::shared_ptr<handler_type>* {
+                std::shared_ptr<handler_type> h = newHandler();
+                return h ? new std::shared_ptr<handler_type>(std::move(h)) : nullptr;
+              },
+              [this](std::shared_ptr<handler_type>* h) {
+                removeHandler(*h);
+                delete h;
+              },
+              m_workerCount + m_maxPending));
+          for (unsigned int i = 0; i < m_workerCount; ++i)
+            m_workers.emplace_back(&TcpServer::workerRunnable, this);
+        }
+
         m_serverThread = std::thread([=](){
           if (!bind(address, port))
           {
@@ -392,6 +1827,18 @@ namespace thisptr {
               std::cout << "s : unable to accept connection" << std::endl;
               break;
             }
+            conn->setMetrics(m_metrics);
+            if (m_metrics)
+              m_metrics->add(Metrics::Accepts);
+
+            if (m_workerCount > 0) {
+              if (!enqueue(conn))
+              {
+                conn->close();
+                std::cout << "s : connection queue is full, refusing connection" << std::endl;
+              }
+              continue;
+            }
 
             std::shared_ptr<handler_type> h = newHandler();
             if (!h)
@@ -400,22 +1847,41 @@ namespace thisptr {
               std::cout << "s : cannot accept connection at this time!" << std::endl;
               continue;
             }
-            h->setTcpConn(conn);
-            h->setTcpServer(this);
-            std::thread(*h).detach();
+            if (!track(conn))
+            {
+              conn->close();
+              removeHandler(h);
+              break;
+            }
+            std::thread([this, h, conn]() mutable {
+              serve(h, conn);
+              removeHandler(h);
+              h.reset();
+              untrack(conn);
+            }).detach();
           }
         });
-        m_serverThread.detach();
       }
 
+      // stops accepting and ends the connections being served, their handlers return once the socket is shut down
       void stop() {
         m_stopRequested = true;
         m_stopCv.notify_all();
+        m_queueCv.notify_all();
+
+        std::lock_guard<std::mutex> lk(m_activeMutex);
+        for (auto& conn: m_active)
+          conn->shutdown();
       }
 
-      void setNewHandler(std::shared_ptr<handler_type>(*newHandler)())
+      void setNewHandler(std::function<std::shared_ptr<handler_type>()> newHandler)
       {
-        m_newHandlerCallback = newHandler;
+        m_newHandlerCallback = std::move(newHandler);
+      }
+
+      void setRemoveHandler(std::function<void(std::shared_ptr<handler_type>)> removeHandler)
+      {
+        m_removeHandlerCallback = std::move(removeHandler);
       }
 
       std::shared_ptr<handler_type> newHandler()
@@ -434,16 +1900,100 @@ namespace thisptr {
           m_removeHandlerCallback(handler);
       }
 
+      // called on a pooled handler after it served a connection, before it serves the next one
+      void setResetHandler(std::function<void(handler_type&)> resetHandler)
+      {
+        m_resetHandlerCallback = std::move(resetHandler);
+      }
+
     protected:
       void stopRunnable() {
         std::unique_lock<std::mutex> lk(m_stopMutex);
-        m_stopCv.wait(lk, [=]{ return m_stopRequested; });
+        m_stopCv.wait(lk, [=]{ return m_stopRequested.load(); });
+        // closing alone does not wake a thread blocked in accept
+        m_sock.shutdown();
         m_sock.close();
       }
 
+      bool enqueue(std::shared_ptr<socket_type>& conn) {
+        {
+          std::lock_guard<std::mutex> lk(m_queueMutex);
+          if (m_pending.size() >= m_maxPending)
+            return false;
+          m_pending.push_back(conn);
+          if (m_metrics)
+            m_metrics->record(Metrics::QueueDepth, m_pending.size());
+        }
+        m_queueCv.notify_one();
+        return true;
+      }
+
+      void workerRunnable() {
+        while (true) {
+          std::shared_ptr<socket_type> conn;
+          {
+            std::unique_lock<std::mutex> lk(m_queueMutex);
+            m_queueCv.wait(lk, [=]{ return m_stopRequested || !m_pending.empty(); });
+            if (m_stopRequested)
+              break;
+            conn = m_pending.front();
+            m_pending.pop_front();
+          }
+
+          // the pool holds more handlers than there are workers, so it only comes back empty if the factory failed
+          std::shared_ptr<handler_type>* h = m_handlerPool->pop();
+          if (!h)
+          {
+            m_handlerPool->discard(nullptr);
+            conn->close();
+            std::cout << "s : cannot accept connection at this time!" << std::endl;
+            continue;
+          }
+          if (!track(conn))
+          {
+            conn->close();
+            m_handlerPool->push(h);
+            break;
+          }
+          serve(*h, conn);
+          if (m_resetHandlerCallback)
+            m_resetHandlerCallback(**h);
+          m_handlerPool->push(h);
+          untrack(conn);
+        }
+
+        std::lock_guard<std::mutex> lk(m_queueMutex);
+        for (auto& conn: m_pending)
+          conn->close();
+        m_pending.clear();
+      }
+
+      // a connection is only served if stop has not swept the active ones yet
+      bool track(const std::shared_ptr<socket_type>& conn) {
+        std::lock_guard<std::mutex> lk(m_activeMutex);
+        if (m_stopRequested)
+          return false;
+        m_active.insert(conn);
+        return true;
+      }
+
+      void serve(const std::shared_ptr<handler_type>& h, std::shared_ptr<socket_type> conn) {
+        std::shared_ptr<socket_type> empty;
+        h->setTcpConn(conn);
+        h->setTcpServer(this);
+        (*h)();
+        h->setTcpConn(empty);
+      }
+
+      void untrack(const std::shared_ptr<socket_type>& conn) {
+        std::lock_guard<std::mutex> lk(m_activeMutex);
+        m_active.erase(conn);
+        m_activeCv.notify_all();
+      }
+
       Socket<socket_type> m_sock;
 
-      bool m_stopRequested = false;
+      std::atomic<bool> m_stopRequested {false};
       std::thread m_serverThread;
       std::thread m_stopThread;
       std::mutex m_stopMutex;
@@ -452,13 +2002,24 @@ namespace thisptr {
       std::string m_address;
       std::string m_port;
 
-      std::shared_ptr<handler_type>(*m_newHandlerCallback)();
-      void(*m_removeHandlerCallback)(std::shared_ptr<handler_type>);
-
+      std::function<std::shared_ptr<handler_type>()> m_newHandlerCallback;
+      std::function<void(std::shared_ptr<handler_type>)> m_removeHandlerCallback;
+      std::function<void(handler_type&)> m_resetHandlerCallback;
+
+      unsigned int m_workerCount {0};
+      std::size_t m_maxPending {0};
+      std::vector<std::thread> m_workers;
+      std::mutex m_queueMutex;
+      std::condition_variable m_queueCv;
+      std::deque<std::shared_ptr<socket_type>> m_pending;
+      std::unique_ptr<thisptr::utils::Pool<std::shared_ptr<handler_type>>> m_handlerPool;
+      std::mutex m_activeMutex;
+      std::condition_variable m_activeCv;
+      std::set<std::shared_ptr<socket_type>> m_active;
     };
 
     template <typename H>
-    class TcpServer<AsioTcpSocket<H>, H>: public TcpServerBase {
+    class TcpServer<AsioTcpSocket<H>, H>: public TcpServerBase, private ConnectionOwner {
       using socket_type = AsioTcpSocket<H>;
       using handler_ptr = std::shared_ptr<H>;
     public:
@@ -466,20 +2027,32 @@ namespace thisptr {
 
       virtual ~TcpServer() {
         stop();
+        // the adopted sockets own the memory of their queued completions
+        m_contextHolder.drain();
+        m_connections.clear();
       }
 
       void start(const std::string& address, const std::string& port) {
         if (!m_stopped)
           return;
 
-        if (!bind(address, port))
-        {
-          std::cout << "s : unable to bind to host" << std::endl;
-          return;
+        if (m_acceptsPerListener > 0) {
+          if (!bindShards(port))
+          {
+            std::cout << "s : unable to bind to host" << std::endl;
+            return;
+          }
+          for (auto& slot: m_acceptSlots)
+            accept(*slot);
+        } else {
+          if (!bind(address, port))
+          {
+            std::cout << "s : unable to bind to host" << std::endl;
+            return;
+          }
+          accept();
         }
 
-        accept();
-
         try {
           m_contextHolder.start();
         } catch (std::exception& e) {
@@ -492,6 +2065,22 @@ namespace thisptr {
         m_contextHolder.waitForFinished();
       }
 
+      // has to be called before start, with contextPerWorker every worker runs its own io_context
+      // and accepted connections are handed to them round-robin
+      void setWorkers(int workers, bool contextPerWorker = false) {
+        m_workerCount = workers;
+        m_contextHolder.setWorkers(workers);
+        m_contextHolder.setContextPerWorker(contextPerWorker);
+      }
+
+      // has to be called before start, opens one SO_REUSEPORT listener per worker (bound to that worker's
+      // io_context when it runs one per worker) so the kernel spreads incoming connections over them,
+      // each listener keeps acceptsPerListener accepts outstanding. onNewConnection is then called
+      // concurrently from several threads. without SO_REUSEPORT a single listener is used.
+      void setShardedAccept(int acceptsPerListener = 4) {
+        m_acceptsPerListener = acceptsPerListener > 0 ? acceptsPerListener : 1;
+      }
+
       void stop() {
         if (m_stopped)
           return;
@@ -500,8 +2089,17 @@ namespace thisptr {
           asio::post(m_acceptor.get_executor(), [this] {
             m_acceptor.cancel();
           });
+        for (auto& shard: m_shards) {
+          asio::ip::tcp::acceptor* acceptor = shard.get();
+          if (acceptor->is_open())
+            asio::post(acceptor->get_executor(), [acceptor] {
+              acceptor->cancel();
+            });
+        }
 
-        m_handler->onServerDisconnected();
+        m_connections.forEach([](ConnectionId, socket_type& conn) { conn.close(); });
+        if (m_handler)
+          m_handler->onServerDisconnected();
         m_contextHolder.stop();
       }
 
@@ -515,29 +2113,207 @@ namespace thisptr {
       }
 
       std::shared_ptr<socket_type> accept() {
-
-        auto* sock = new asio::ip::tcp::socket(m_contextHolder.ctx());
-        m_acceptor.async_accept(*sock,
-                                [this, sock](std::error_code ec)
+        m_acceptor.async_accept(m_contextHolder.nextCtx(),
+                                makeAllocHandler(m_acceptMemory, [this](asio::error_code ec, asio::ip::tcp::socket sock)
                                 {
                                   if (ec)
                                   {
-                                    std::cerr << "unable to accept connection, ec: " << ec << std::endl;
+                                    if (ec != asio::error::operation_aborted)
+                                      std::cerr << "unable to accept connection, ec: " << ec << std::endl;
                                     stop();
                                   } else {
-                                    m_handler->onNewConnection(*sock);
+                                    if (m_metrics)
+                                      m_metrics->add(Metrics::Accepts);
+                                    m_handler->onNewConnection(sock);
                                     accept();
                                   }
-                                });
+                                }));
 
         return nullptr;
       }
 
+      // keeps the connection in the server's table, which closes it when a read fails and frees it once
+      // closed. meant to be called from onNewConnection, the id stays valid until the connection is gone
+      ConnectionId adopt(asio::ip::tcp::socket& sock, handler_ptr handler = nullptr) {
+        auto res = m_connections.emplace(sock, handler ? handler : m_handler);
+        res.second->setMetrics(m_metrics);
+        res.second->setOwner(this, res.first);
+        return res.first;
+      }
+
+      // nullptr once closed, only safe to hold on to from the connection's own callbacks
+      socket_type* connection(ConnectionId id) {
+        return m_connections.find(id);
+      }
+
+      // calls f(socket_type&) if the connection is still there, safe from any thread
+      template <typename F>
+      bool withConnection(ConnectionId id, F&& f) {
+        return m_connections.visit(id, std::forward<F>(f));
+      }
+
+      // calls f(ConnectionId, socket_type&) for every adopted connection, e.g. to broadcast
+      template <typename F>
+      void forEachConnection(F&& f) {
+        m_connections.forEach(std::forward<F>(f));
+      }
+
+      bool close(ConnectionId id) {
+        return m_connections.visit(id, [](socket_type& conn) { conn.close(); });
+      }
+
+      // queues the one payload on every open adopted connection without copying it, returns how many got it
+      std::size_t broadcast(SharedBuffer payload) {
+        return broadcast(std::move(payload), [](ConnectionId, socket_type&) { return true; });
+      }
+
+      std::size_t broadcast(std::string payload) {
+        return broadcast(makeSharedBuffer(std::move(payload)));
+      }
+
+      // same, limited to the connections filter(ConnectionId, socket_type&) returns true for
+      template <typename F>
+      std::size_t broadcast(SharedBuffer payload, F&& filter) {
+        std::size_t count = 0;
+        m_connections.forEach([&](ConnectionId id, socket_type& conn) {
+          if (conn.isOpen() && filter(id, conn)) {
+            conn.send(payload);
+            count++;
+          }
+        });
+        return count;
+      }
+
+      std::size_t connections() {
+        return m_connections.size();
+      }
+
+#ifdef WITH_COROUTINES
+      struct AcceptResult {
+        std::error_code ec;
+        std::shared_ptr<socket_type> socket;
+      };
+
+      // binds and runs the workers without the callback accept loop, connections are taken with asyncAccept
+      bool listen(const std::string& address, const std::string& port) {
+        if (!m_stopped)
+          return true;
+
+        try {
+          bind(address, port);
+          m_contextHolder.start();
+        } catch (std::exception& e) {
+          std::cout << "s : unable to bind to host" << std::endl;
+          return false;
+        }
+        m_stopped = false;
+        return true;
+      }
+
+      // runs a coroutine on the next of the server's io_contexts
+      template <typename F>
+      void spawn(F&& coroutine) {
+        asio::co_spawn(m_contextHolder.nextCtx(), std::forward<F>(coroutine), asio::detached);
+      }
+
+      // e.g. auto [ec, conn] = co_await server.asyncAccept(); the socket is bound to the next io_context
+      asio::awaitable<AcceptResult> asyncAccept() {
+        asio::ip::tcp::socket sock(m_contextHolder.nextCtx());
+        asio::error_code error;
+        co_await m_acceptor.async_accept(sock, asio::redirect_error(asio::use_awaitable, error));
+        if (error)
+          co_return AcceptResult{error, nullptr};
+
+        if (m_metrics)
+          m_metrics->add(Metrics::Accepts);
+        auto conn = std::make_shared<socket_type>(sock, m_handler);
+        conn->setMetrics(m_metrics);
+        co_return AcceptResult{{}, conn};
+      }
+#endif
+
     protected:
+      struct AcceptSlot {
+        asio::ip::tcp::acceptor* acceptor;
+        asio::io_context* context;
+        HandlerMemory memory;
+      };
+
+      bool bindShards(const std::string& port) {
+        asio::ip::tcp::endpoint endpoint(asio::ip::tcp::v4(), std::stoi(port));
+#ifdef SO_REUSEPORT
+        using reuse_port = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+        std::size_t listeners = std::max<std::size_t>(m_contextHolder.contexts(), (std::size_t)m_workerCount);
+#else
+        std::size_t listeners = 1;
+#endif
+
+        try {
+          for (std::size_t i = 0; i < listeners; ++i) {
+            asio::io_context& context = m_contextHolder.ctx(i);
+            std::unique_ptr<asio::ip::tcp::acceptor> acceptor(new asio::ip::tcp::acceptor(context));
+            acceptor->open(endpoint.protocol());
+            acceptor->set_option(asio::ip::tcp::acceptor::reuse_address(true));
+#ifdef SO_REUSEPORT
+            acceptor->set_option(reuse_port(true));
+#endif
+            acceptor->bind(endpoint);
+            acceptor->listen();
+
+            for (int j = 0; j < m_acceptsPerListener; ++j) {
+              std::unique_ptr<AcceptSlot> slot(new AcceptSlot);
+              slot->acceptor = acceptor.get();
+              slot->context = &context;
+              m_acceptSlots.push_back(std::move(slot));
+            }
+            m_shards.push_back(std::move(acceptor));
+          }
+        } catch (std::exception& e) {
+          std::cerr << "exception occured on asio bind" << e.what() << std::endl;
+          m_acceptSlots.clear();
+          m_shards.clear();
+          return false;
+        }
+        return true;
+      }
+
+      void accept(AcceptSlot& slot) {
+        slot.acceptor->async_accept(*slot.context,
+                                    makeAllocHandler(slot.memory, [this, &slot](asio::error_code ec, asio::ip::tcp::socket sock)
+                                    {
+                                      if (ec)
+                                      {
+                                        if (ec == asio::error::operation_aborted)
+                                          return;
+                                        std::cerr << "unable to accept connection, ec: " << ec << std::endl;
+                                        stop();
+                                      } else {
+                                        if (m_metrics)
+                                          m_metrics->add(Metrics::Accepts);
+                                        m_handler->onNewConnection(sock);
+                                        accept(slot);
+                                      }
+                                    }));
+      }
+
       AsioContextHolder m_contextHolder;
       asio::ip::tcp::acceptor m_acceptor;
+      HandlerMemory m_acceptMemory;
       handler_ptr m_handler;
       bool m_stopped {true};
+
+      int m_acceptsPerListener {0};
+      int m_workerCount {1};
+      std::vector<std::unique_ptr<asio::ip::tcp::acceptor>> m_shards;
+      std::vector<std::unique_ptr<AcceptSlot>> m_acceptSlots;
+
+      // declared last so the sockets go before the contexts they run on
+      ConnectionTable<socket_type> m_connections;
+
+    private:
+      void release(ConnectionId id) override {
+        m_connections.erase(id);
+      }
     };
 
     template <typename H>
@@ -548,6 +2324,14 @@ namespace thisptr {
 
     template <typename H>
     using AsyncTcpClient = Socket<AsioTcpSocket<H>>;
+
+#ifdef WITH_COROUTINES
+    // for sockets and servers only driven through the coroutine interface, ignores every callback
+    class CoroutineHandler: public StaticConnectionHandlerBase<CoroutineHandler> {};
+
+    using CoroutineTcpSocket = AsioTcpSocket<CoroutineHandler>;
+    using CoroutineTcpServer = AsyncTcpServer<CoroutineHandler>;
+#endif
   }
 }
 
@@ -3,8 +3,13 @@
 
 #include <condition_variable>
 #include <functional>
+#include <mutex>
 #include <vector>
 #include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
 
 namespace thisptr {
   namespace utils {
@@ -64,21 +69,18 @@ namespace thisptr {
           }
         }
         if (timeout > 0) {
-          std::unique_lock<std::mutex> lkCv(m_cvMutex);
-          if (timeout > 0 && m_cv.wait_for(lkCv, timeout * 1ms, [=]{ return !m_elems.empty(); })) {
-            {
-              std::lock_guard<std::mutex> lk(m_vecMutex);
-
-              if (!m_elems.empty()) {
-                T *t = m_elems.back();
-                m_elems.pop_back();
-                m_popped++;
-                return t;
-              } else if (m_popped < m_cap) {
-                T *t = m_cFunc(std::forward<Args>(args)...);
-                m_popped++;
-                return t;
-              }
+          // waits on m_vecMutex, the one push and discard change the predicate under, so no notify is missed
+          std::unique_lock<std::mutex> lk(m_vecMutex);
+          if (m_cv.wait_for(lk, timeout * 1ms, [=]{ return !m_elems.empty() || m_popped < (int)m_cap; })) {
+            if (!m_elems.empty()) {
+              T *t = m_elems.back();
+              m_elems.pop_back();
+              m_popped++;
+              return t;
+            } else if (m_popped < m_cap) {
+              T *t = m_cFunc(std::forward<Args>(args)...);
+              m_popped++;
+              return t;
             }
           }
         }
@@ -95,7 +97,38 @@ namespace thisptr {
           m_dFunc(elem);
       }
 
+      // destroys a popped element instead of returning it, its slot can be filled by a new one
+      void discard(T* elem) {
+        {
+          std::lock_guard<std::mutex> lk(m_vecMutex);
+          m_popped--;
+          m_cv.notify_one();
+        }
+        if (elem && m_dFunc)
+          m_dFunc(elem);
+      }
+
+      // destroys the idle elements matching pred, returns how many were destroyed
+      std::size_t evict(const std::function<bool (T*)>& pred) {
+        std::vector<T*> evicted;
+        {
+          std::lock_guard<std::mutex> lk(m_vecMutex);
+          auto it = std::stable_partition(m_elems.begin(), m_elems.end(), [&pred](T* elem) { return !pred(elem); });
+          evicted.assign(it, m_elems.end());
+          m_elems.erase(it, m_elems.end());
+        }
 
+        for (auto& elem: evicted) {
+          if (m_dFunc)
+            m_dFunc(elem);
+        }
+        return evicted.size();
+      }
+
+      std::size_t idle() {
+        std::lock_guard<std::mutex> lk(m_vecMutex);
+        return m_elems.size();
+      }
 
     private:
       std::function<T* (Args && ...)> m_cFunc;
@@ -106,6 +139,246 @@ namespace thisptr {
       std::mutex m_vecMutex;
       std::vector<T*> m_elems;
 
+      std::condition_variable m_cv;
+    };
+
+    // Same contract as Pool (capacity, create/destroy functors, timed pop) without a global lock:
+    // every thread recycles objects through a small magazine of its own and only touches the shared
+    // depot, a lock-free bounded queue, when the magazine runs empty or full. Magazines are guarded by
+    // a spinlock that is only contended when more than kMagazineSlots threads share them, or when an
+    // exhausted pool takes objects parked in another thread's magazine.
+    template <typename T, typename ...Args>
+    class ThreadCachingPool {
+      static constexpr std::size_t kMagazineSize = 32;
+      static constexpr std::size_t kMagazineSlots = 64;
+
+      struct alignas(64) Magazine {
+        std::atomic_flag busy = ATOMIC_FLAG_INIT;
+        std::size_t count {0};
+        T* items[kMagazineSize];
+      };
+
+      // bounded multi-producer/multi-consumer queue, see Dmitry Vyukov's bounded mpmc queue
+      struct Cell {
+        std::atomic<std::size_t> seq;
+        T* data;
+      };
+
+    public:
+      ThreadCachingPool() : ThreadCachingPool(nullptr, nullptr) {}
+      ~ThreadCachingPool() {
+        clear();
+      };
+
+      void operator=(const ThreadCachingPool<T>&) = delete;
+      void operator=(const ThreadCachingPool<T>&&) = delete;
+
+      ThreadCachingPool(std::function<T* (Args && ...)>&& cFun, std::function<void (T*)>&& dFunc, std::size_t capacity = 1) {
+        m_cFunc = std::move(cFun);
+        m_dFunc = std::move(dFunc);
+        m_cap = capacity;
+
+        std::size_t cells = 2;
+        while (cells < capacity)
+          cells <<= 1;
+        m_mask = cells - 1;
+        m_cells.reset(new Cell[cells]);
+        for (std::size_t i = 0; i < cells; ++i)
+          m_cells[i].seq.store(i, std::memory_order_relaxed);
+      }
+
+      void clear() {
+        T* elem;
+        for (auto& mag: m_magazines) {
+          lock(mag);
+          while (mag.count > 0)
+            destroy(mag.items[--mag.count]);
+          unlock(mag);
+        }
+        while (depotPop(elem))
+          destroy(elem);
+      }
+
+      bool isEmpty() {
+        return !(m_depotSize.load(std::memory_order_relaxed) > 0 || m_created.load(std::memory_order_relaxed) < (long)m_cap);
+      }
+
+      T* pop(int timeout = 0, Args && ...args) {
+        using namespace std::chrono_literals;
+
+        T* t = tryPop(std::forward<Args>(args)...);
+        if (t || timeout <= 0)
+          return t;
+
+        auto deadline = std::chrono::steady_clock::now() + timeout * 1ms;
+        m_waiters.fetch_add(1);
+        {
+          std::unique_lock<std::mutex> lkCv(m_cvMutex);
+          while ((t = tryPop(std::forward<Args>(args)...)) == nullptr) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline)
+              break;
+            // objects can also come back through other threads' magazines, which does not notify
+            m_cv.wait_until(lkCv, std::min(deadline, now + 10ms));
+          }
+        }
+        m_waiters.fetch_sub(1);
+        return t;
+      }
+
+      void push(T* elem) {
+        // somebody is blocked in pop, hand the object over through the depot so it can see it
+        if (m_waiters.load() > 0) {
+          release(elem);
+          std::lock_guard<std::mutex> lk(m_cvMutex);
+          m_cv.notify_one();
+          return;
+        }
+
+        Magazine& mag = m_magazines[slot()];
+        if (tryLock(mag)) {
+          if (mag.count == kMagazineSize) {
+            // keep the newest half hot in this thread, spill the rest
+            for (std::size_t i = 0; i < kMagazineSize / 2; ++i)
+              release(mag.items[i]);
+            std::move(mag.items + kMagazineSize / 2, mag.items + kMagazineSize, mag.items);
+            mag.count = kMagazineSize - kMagazineSize / 2;
+          }
+          mag.items[mag.count++] = elem;
+          unlock(mag);
+          return;
+        }
+        release(elem);
+      }
+
+    private:
+      static std::size_t slot() {
+        static std::atomic<std::size_t> nextSlot {0};
+        thread_local std::size_t mySlot = nextSlot.fetch_add(1) % kMagazineSlots;
+        return mySlot;
+      }
+
+      static bool tryLock(Magazine& mag) {
+        return !mag.busy.test_and_set(std::memory_order_acquire);
+      }
+
+      static void lock(Magazine& mag) {
+        while (mag.busy.test_and_set(std::memory_order_acquire))
+          std::this_thread::yield();
+      }
+
+      static void unlock(Magazine& mag) {
+        mag.busy.clear(std::memory_order_release);
+      }
+
+      T* tryPop(Args && ...args) {
+        Magazine& mag = m_magazines[slot()];
+        if (tryLock(mag)) {
+          if (mag.count > 0) {
+            T* t = mag.items[--mag.count];
+            unlock(mag);
+            return t;
+          }
+          unlock(mag);
+        }
+
+        T* t;
+        if (depotPop(t))
+          return t;
+
+        long created = m_created.load();
+        while (created < (long)m_cap) {
+          if (m_created.compare_exchange_weak(created, created + 1))
+            return m_cFunc(std::forward<Args>(args)...);
+        }
+
+        // objects parked in magazines of other (possibly finished) threads still count against the capacity
+        for (auto& other: m_magazines) {
+          if (&other == &mag || !tryLock(other))
+            continue;
+          if (other.count > 0) {
+            t = other.items[--other.count];
+            unlock(other);
+            return t;
+          }
+          unlock(other);
+        }
+        return nullptr;
+      }
+
+      void release(T* elem) {
+        // the depot holds as many as the pool creates, so it only looks full while a pop is
+        // still finishing on the next cell
+        for (int i = 0; i < 16; ++i) {
+          if (depotPush(elem))
+            return;
+          std::this_thread::yield();
+        }
+        destroy(elem);
+      }
+
+      void destroy(T* elem) {
+        if (m_dFunc)
+          m_dFunc(elem);
+        m_created.fetch_sub(1);
+      }
+
+      bool depotPush(T* elem) {
+        std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+          Cell& cell = m_cells[pos & m_mask];
+          std::size_t seq = cell.seq.load(std::memory_order_acquire);
+          auto diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)pos;
+          if (diff == 0) {
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+              cell.data = elem;
+              cell.seq.store(pos + 1, std::memory_order_release);
+              m_depotSize.fetch_add(1, std::memory_order_relaxed);
+              return true;
+            }
+          } else if (diff < 0) {
+            return false;
+          } else {
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+          }
+        }
+      }
+
+      bool depotPop(T*& elem) {
+        std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        while (true) {
+          Cell& cell = m_cells[pos & m_mask];
+          std::size_t seq = cell.seq.load(std::memory_order_acquire);
+          auto diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)(pos + 1);
+          if (diff == 0) {
+            if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+              elem = cell.data;
+              cell.seq.store(pos + m_mask + 1, std::memory_order_release);
+              m_depotSize.fetch_sub(1, std::memory_order_relaxed);
+              return true;
+            }
+          } else if (diff < 0) {
+            return false;
+          } else {
+            pos = m_dequeuePos.load(std::memory_order_relaxed);
+          }
+        }
+      }
+
+      std::function<T* (Args && ...)> m_cFunc;
+      std::function<void (T*)> m_dFunc;
+      std::size_t m_cap{};
+      std::atomic<long> m_created {0};
+
+      Magazine m_magazines[kMagazineSlots];
+
+      std::unique_ptr<Cell[]> m_cells;
+      std::size_t m_mask {0};
+      alignas(64) std::atomic<std::size_t> m_enqueuePos {0};
+      alignas(64) std::atomic<std::size_t> m_dequeuePos {0};
+      std::atomic<long> m_depotSize {0};
+
+      std::atomic<int> m_waiters {0};
       std::mutex m_cvMutex;
       std::condition_variable m_cv;
     };
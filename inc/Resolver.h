@@ -0,0 +1,81 @@
+#ifndef NetLib_RESOLVER_H
+#define NetLib_RESOLVER_H
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <net_p.h>
+
+namespace thisptr {
+  namespace net {
+
+    // A copy of a lookup result in resolver order. addresses() is an addrinfo chain pointing into the copy,
+    // ready for net_p::connectTimeout. Built once and only read afterwards, so it is shared between threads.
+    class ResolvedAddresses {
+    public:
+      ResolvedAddresses() = default;
+      explicit ResolvedAddresses(const struct addrinfo* list);
+
+      ResolvedAddresses(const ResolvedAddresses&) = delete;
+      ResolvedAddresses& operator=(const ResolvedAddresses&) = delete;
+
+      void add(int family, int socktype, int protocol, const struct sockaddr* addr, std::size_t len);
+
+      const struct addrinfo* addresses() const { return m_chain.empty() ? nullptr : &m_chain.front(); }
+      std::size_t size() const { return m_chain.size(); }
+      bool empty() const { return m_chain.empty(); }
+
+    private:
+      std::vector<struct addrinfo> m_chain;
+      std::vector<struct sockaddr_storage> m_storage;
+    };
+
+    // Lookups shared by every socket, so reconnecting does not go through getaddrinfo each time. The resolver
+    // does not tell the record ttl, entries are kept for a fixed ttl instead (30s by default). At most
+    // capacity entries are held, the ones expiring first make room. Thread-safe.
+    class ResolverCache {
+    public:
+      using clock = std::chrono::steady_clock;
+      using Entry = std::shared_ptr<const ResolvedAddresses>;
+
+      ResolverCache() = default;
+      ResolverCache(const ResolverCache&) = delete;
+      ResolverCache& operator=(const ResolverCache&) = delete;
+
+      // cache the sockets use unless told otherwise
+      static ResolverCache& global();
+
+      void setTtl(std::chrono::milliseconds ttl);
+      void setCapacity(std::size_t capacity);
+
+      // nullptr unless cached and not expired yet
+      Entry find(const std::string& host, const std::string& port);
+      void store(const std::string& host, const std::string& port, Entry addresses);
+      // e.g. once none of the addresses answered, so the next connect looks the name up again
+      void erase(const std::string& host, const std::string& port);
+      void clear();
+      std::size_t size();
+
+      // the cached entry, or a blocking lookup that is stored. nullptr if the name does not resolve
+      Entry resolve(const std::string& host, const std::string& port);
+
+    private:
+      struct Cached {
+        Entry addresses;
+        clock::time_point expires;
+      };
+
+      static std::string key(const std::string& host, const std::string& port);
+
+      std::mutex m_mutex;
+      std::unordered_map<std::string, Cached> m_entries;
+      std::chrono::milliseconds m_ttl {30000};
+      std::size_t m_capacity {1024};
+    };
+  }
+}
+
+#endif //NetLib_RESOLVER_H
@@ -0,0 +1,84 @@
+#ifndef NetLib_TIMINGWHEEL_H
+#define NetLib_TIMINGWHEEL_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace thisptr {
+  namespace net {
+
+    // Hierarchical hashed timing wheel: 4 levels of 64 slots, so arming and cancelling a timer are O(1)
+    // list operations no matter how many are pending. Timeouts are rounded up to whole ticks and capped at
+    // 64^4 ticks (about 46 hours with the default 10ms tick). Not thread-safe, every wheel belongs to the
+    // reactor thread that advances it.
+    class TimingWheel {
+      struct Node {
+        Node* prev {nullptr};
+        Node* next {nullptr};
+      };
+
+    public:
+      using clock = std::chrono::steady_clock;
+      using Callback = std::function<void()>;
+
+      static constexpr int kLevels = 4;
+      static constexpr int kSlotBits = 6;
+      static constexpr int kSlots = 1 << kSlotBits;
+
+      // intrusive entry, owned by whoever arms it and cancelled automatically when destroyed
+      class Timer: private Node {
+      public:
+        Timer() = default;
+        ~Timer() { cancel(); }
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+        bool isArmed() const { return next != nullptr; }
+        void cancel();
+
+      private:
+        friend class TimingWheel;
+        TimingWheel* m_wheel {nullptr};
+        std::uint64_t m_expiry {0};
+        Callback m_callback;
+      };
+
+      explicit TimingWheel(std::chrono::milliseconds tick = std::chrono::milliseconds(10));
+      ~TimingWheel();
+
+      TimingWheel(const TimingWheel&) = delete;
+      TimingWheel& operator=(const TimingWheel&) = delete;
+
+      // (re)arms timer to call callback once timeout has passed, moving it if it was armed already
+      void arm(Timer& timer, std::chrono::milliseconds timeout, Callback callback);
+      // re-arms with the callback it already has
+      void rearm(Timer& timer, std::chrono::milliseconds timeout);
+      void cancel(Timer& timer);
+
+      // fires every timer that expired up to now, returns how many
+      std::size_t advance(clock::time_point now = clock::now());
+
+      std::chrono::milliseconds tick() const { return m_tick; }
+      std::size_t size() const { return m_count; }
+      bool empty() const { return m_count == 0; }
+
+    private:
+      static void link(Node& head, Node& node);
+      static void unlink(Node& node);
+
+      void insert(Timer& timer);
+      void cascade(int level, int slot);
+      std::size_t expire(int slot);
+
+      std::chrono::milliseconds m_tick;
+      clock::time_point m_start;
+      std::uint64_t m_now {0};
+      std::size_t m_count {0};
+      Node m_slots[kLevels][kSlots];
+    };
+  }
+}
+
+#endif //NetLib_TIMINGWHEEL_H
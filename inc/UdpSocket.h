@@ -0,0 +1,145 @@
+#ifndef NetLib_UDPSOCKET_H
+#define NetLib_UDPSOCKET_H
+
+#include <Net.h>
+
+namespace thisptr {
+  namespace net {
+
+    // resolved datagram peer address
+    struct UdpEndpoint {
+      sockaddr_storage addr {};
+      socklen_t len {0};
+
+      static bool resolve(const std::string& address, const std::string& port, UdpEndpoint& endpoint);
+
+      std::string address() const;
+      unsigned short port() const;
+    };
+
+    // one datagram of a batch, data points to caller owned memory
+    struct Datagram {
+      char* data {nullptr};
+      std::size_t size {0};     // bytes received, or bytes to send
+      std::size_t capacity {0}; // room behind data when receiving
+      bool truncated {false};   // the datagram did not fit into capacity
+      UdpEndpoint peer;         // sender when receiving, destination when sending (empty for the connected peer)
+    };
+
+    class UdpSocket {
+    public:
+      // upper bound of datagrams moved by one recvmmsg/sendmmsg call
+      static constexpr int kMaxBatch = 64;
+
+      UdpSocket() : UdpSocket(INVALID_SOCKET) {}
+      explicit UdpSocket(unsigned long long sock);
+      virtual ~UdpSocket();
+
+      UdpSocket(const UdpSocket&) = delete;
+      UdpSocket& operator=(const UdpSocket&) = delete;
+
+      bool bind(const std::string& address, const std::string& port);
+      // sets the default peer, send and recv only talk to it afterwards
+      bool connect(const std::string& address, const std::string& port);
+
+      int recv(char* buf, int len);
+      int recvFrom(char* buf, int len, UdpEndpoint& from);
+      int send(const char* buf);
+      int send(const char* buf, int len);
+      int sendTo(const char* buf, int len, const UdpEndpoint& to);
+
+      // blocks for the first datagram and takes whatever else is already queued with the same syscall,
+      // returns the number of datagrams received or a negative error
+      int recvBatch(Datagram* datagrams, int count);
+      // returns the number of datagrams sent, which is less than count only on error
+      int sendBatch(const Datagram* datagrams, int count);
+
+      // iface is the local interface address for ipv4 groups, or the interface name for ipv6 groups
+      bool joinGroup(const std::string& group, const std::string& iface = "");
+      bool leaveGroup(const std::string& group, const std::string& iface = "");
+      bool setMulticastLoop(bool enabled);
+      bool setMulticastTtl(int ttl);
+
+      bool close();
+
+      bool isOpen() const { return m_sock != INVALID_SOCKET; }
+      unsigned long long handle() const { return m_sock; }
+
+    protected:
+      bool membership(const std::string& group, const std::string& iface, bool join);
+      int family() const;
+
+      unsigned long long m_sock;
+    };
+
+    template <>
+    class Socket<UdpSocket> {
+    public:
+      Socket() = default;
+      ~Socket() = default;
+
+      bool bind(const std::string& address, const std::string& port) {
+        return m_sock.bind(address, port);
+      }
+
+      bool connect(const std::string& address, const std::string& port) {
+        return m_sock.connect(address, port);
+      }
+
+      int recv(char* buf, int len) {
+        return m_sock.recv(buf, len);
+      }
+
+      int recvFrom(char* buf, int len, UdpEndpoint& from) {
+        return m_sock.recvFrom(buf, len, from);
+      }
+
+      int recvBatch(Datagram* datagrams, int count) {
+        return m_sock.recvBatch(datagrams, count);
+      }
+
+      int send(const char* buf) {
+        return m_sock.send(buf);
+      }
+
+      int send(const char* buf, int len) {
+        return m_sock.send(buf, len);
+      }
+
+      int sendTo(const char* buf, int len, const UdpEndpoint& to) {
+        return m_sock.sendTo(buf, len, to);
+      }
+
+      int sendBatch(const Datagram* datagrams, int count) {
+        return m_sock.sendBatch(datagrams, count);
+      }
+
+      bool joinGroup(const std::string& group, const std::string& iface = "") {
+        return m_sock.joinGroup(group, iface);
+      }
+
+      bool leaveGroup(const std::string& group, const std::string& iface = "") {
+        return m_sock.leaveGroup(group, iface);
+      }
+
+      bool setMulticastLoop(bool enabled) {
+        return m_sock.setMulticastLoop(enabled);
+      }
+
+      bool setMulticastTtl(int ttl) {
+        return m_sock.setMulticastTtl(ttl);
+      }
+
+      bool close() {
+        return m_sock.close();
+      }
+
+    private:
+      UdpSocket m_sock;
+    };
+
+    using UdpClient = Socket<UdpSocket>;
+  }
+}
+
+#endif //NetLib_UDPSOCKET_H
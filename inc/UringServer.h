@@ -0,0 +1,548 @@
+#ifndef NetLib_URINGSERVER_H
+#define NetLib_URINGSERVER_H
+
+#if defined(__linux__) && defined(WITH_URING)
+
+#include <liburing.h>
+#include <sys/eventfd.h>
+#include <sys/utsname.h>
+#include <poll.h>
+#include <cstdio>
+#include <cstdint>
+#include <unordered_map>
+#include <EpollServer.h>
+
+namespace thisptr {
+  namespace net {
+
+    class UringLoop {
+    public:
+      virtual ~UringLoop() = default;
+      virtual int queueSend(std::uint32_t id, const char* buf, int len) = 0;
+    };
+
+    // BlockingTcpSocket whose sends are queued to the io_uring loop that owns the connection.
+    // Used standalone (e.g. through Socket<S> / TcpClient<S>) it behaves like a BlockingTcpSocket.
+    class UringTcpSocket: public BlockingTcpSocket {
+    public:
+      UringTcpSocket() = default;
+      UringTcpSocket(unsigned long long sock, UringLoop* loop, std::uint32_t id) :
+      BlockingTcpSocket(sock), m_loop(loop), m_id(id) {}
+
+      int send(const char* buf) override {
+        return send(buf, (int)strlen(buf));
+      }
+
+      int send(const char* buf, int len) override {
+        if (!m_loop)
+          return BlockingTcpSocket::send(buf, len);
+        if (!isOpen())
+          return thisptr::net_p::NETE_Notconnected;
+        return m_loop->queueSend(m_id, buf, len);
+      }
+
+      // queued like the others, the loop writes one connection's payloads in order
+      int send(std::string&& payload) override {
+        if (!m_loop)
+          return BlockingTcpSocket::send(std::move(payload));
+        return send(payload.data(), (int)payload.size());
+      }
+
+      // a blocking write from the loop thread would overtake what is still queued, so the loop refuses files
+      long long sendFile(int fd, long long offset, std::size_t length) override {
+        if (!m_loop)
+          return BlockingTcpSocket::sendFile(fd, offset, length);
+        errno = EOPNOTSUPP;
+        return thisptr::net_p::NETE_SocketError;
+      }
+
+    private:
+      UringLoop* m_loop {nullptr};
+      std::uint32_t m_id {0};
+    };
+
+    // Single threaded io_uring server for BlockingTcpHandler based handlers: one multishot accept,
+    // multishot recv into a provided buffer ring per connection and sends batched into one submission
+    // per loop iteration. Falls back to EpollTcpServer when the kernel lacks the needed features.
+    template <typename H>
+    class TcpServer<UringTcpSocket, H>: public TcpServerBase, protected UringLoop {
+      using handler_type = H;
+      using handler_ptr = std::shared_ptr<H>;
+
+      static constexpr unsigned kEntries = 4096;
+      static constexpr unsigned kBufferCount = 4096;
+      static constexpr unsigned kBufferSize = 4096;
+      static constexpr int kBufferGroup = 0;
+
+      enum OpType: std::uint64_t { OP_ACCEPT = 1, OP_RECV, OP_SEND, OP_WAKE, OP_CANCEL };
+
+      struct Connection {
+        std::shared_ptr<UringTcpSocket> conn;
+        handler_ptr handler;
+        std::string inflight;
+        std::size_t inflightOffset {0};
+        bool sending {false}; // a send sqe points into inflight until its cqe arrives
+      };
+
+    public:
+      TcpServer() = default;
+
+      virtual ~TcpServer() {
+        stop();
+        waitForFinished();
+      }
+
+      void setNewHandler(std::function<std::shared_ptr<handler_type>()> newHandler)
+      {
+        m_newHandlerCallback = std::move(newHandler);
+      }
+
+      // checks whether the running kernel supports everything this backend uses
+      // (multishot accept/recv, provided buffer rings, fd cancellation, linux 6.0+).
+      static bool isSupported() {
+        struct utsname name{};
+        int major = 0, minor = 0;
+        if (uname(&name) != 0 || sscanf(name.release, "%d.%d", &major, &minor) != 2)
+          return false;
+        if (major < 6)
+          return false;
+
+        struct io_uring ring{};
+        if (io_uring_queue_init(8, &ring, 0) < 0)
+          return false;
+        io_uring_queue_exit(&ring);
+        return true;
+      }
+
+      bool isFallback() const {
+        return m_fallback != nullptr;
+      }
+
+      void start(const std::string& address, const std::string& port) {
+        if (m_loopThread.joinable() || m_fallback)
+          return;
+
+        if (!isSupported() || !setupRing()) {
+          std::cerr << "io_uring is not available, falling back to epoll" << std::endl;
+          m_fallback.reset(new EpollTcpServer<handler_type>());
+          m_fallback->setNewHandler(m_newHandlerCallback);
+          m_fallback->setMetrics(m_metrics);
+          m_fallback->start(address, port);
+          return;
+        }
+
+        if (thisptr::net_p::listen(m_listenSock, address.c_str(), port.c_str()) != thisptr::net_p::NETE_Success ||
+            m_listenSock == INVALID_SOCKET)
+        {
+          std::cout << "s : unable to bind to host" << std::endl;
+          teardownRing();
+          return;
+        }
+
+        m_stopRequested = false;
+        m_loopThread = std::thread(&TcpServer::run, this);
+      }
+
+      void stop() {
+        if (m_fallback) {
+          m_fallback->stop();
+          return;
+        }
+        m_stopRequested = true;
+        wake();
+      }
+
+      void waitForFinished() {
+        if (m_fallback) {
+          m_fallback->waitForFinished();
+          return;
+        }
+        if (m_loopThread.joinable())
+          m_loopThread.join();
+      }
+
+      std::shared_ptr<handler_type> newHandler()
+      {
+        if (!m_newHandlerCallback)
+        {
+          std::cerr << "you need some initialization for your server!" << std::endl;
+          return nullptr;
+        }
+        return m_newHandlerCallback();
+      }
+
+    protected:
+      static std::uint64_t encode(OpType op, std::uint32_t id) {
+        return (static_cast<std::uint64_t>(op) << 56) | id;
+      }
+
+      bool setupRing() {
+        if (io_uring_queue_init(kEntries, &m_ring, 0) < 0)
+          return false;
+
+        int ret = 0;
+        m_bufRing = io_uring_setup_buf_ring(&m_ring, kBufferCount, kBufferGroup, 0, &ret);
+        if (!m_bufRing) {
+          io_uring_queue_exit(&m_ring);
+          return false;
+        }
+
+        m_buffers.resize(static_cast<std::size_t>(kBufferCount) * kBufferSize);
+        for (unsigned i = 0; i < kBufferCount; ++i)
+          io_uring_buf_ring_add(m_bufRing, bufferAt(i), kBufferSize, i, io_uring_buf_ring_mask(kBufferCount), i);
+        io_uring_buf_ring_advance(m_bufRing, kBufferCount);
+
+        m_wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_wakefd < 0) {
+          io_uring_free_buf_ring(&m_ring, m_bufRing, kBufferCount, kBufferGroup);
+          io_uring_queue_exit(&m_ring);
+          return false;
+        }
+        m_ringReady = true;
+        return true;
+      }
+
+      void teardownRing() {
+        if (!m_ringReady)
+          return;
+        m_ringReady = false;
+        io_uring_free_buf_ring(&m_ring, m_bufRing, kBufferCount, kBufferGroup);
+        io_uring_queue_exit(&m_ring);
+        ::close(m_wakefd);
+        m_wakefd = -1;
+      }
+
+      char* bufferAt(unsigned bid) {
+        return m_buffers.data() + static_cast<std::size_t>(bid) * kBufferSize;
+      }
+
+      void recycleBuffer(unsigned bid) {
+        io_uring_buf_ring_add(m_bufRing, bufferAt(bid), kBufferSize, bid, io_uring_buf_ring_mask(kBufferCount), 0);
+        io_uring_buf_ring_advance(m_bufRing, 1);
+      }
+
+      void wake() {
+        if (m_wakefd < 0)
+          return;
+        uint64_t one = 1;
+        if (::write(m_wakefd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+          std::cerr << "unable to wake io_uring loop: " << thisptr::net_p::lastErrorString() << std::endl;
+      }
+
+      io_uring_sqe* sqe() {
+        io_uring_sqe* s = io_uring_get_sqe(&m_ring);
+        if (!s) {
+          // submission queue is full, flush it and try again
+          io_uring_submit(&m_ring);
+          s = io_uring_get_sqe(&m_ring);
+        }
+        return s;
+      }
+
+      void armAccept() {
+        io_uring_sqe* s = sqe();
+        io_uring_prep_multishot_accept(s, (int)m_listenSock, nullptr, nullptr, 0);
+        io_uring_sqe_set_data64(s, encode(OP_ACCEPT, 0));
+      }
+
+      void armWake() {
+        io_uring_sqe* s = sqe();
+        io_uring_prep_poll_multishot(s, m_wakefd, POLLIN);
+        io_uring_sqe_set_data64(s, encode(OP_WAKE, 0));
+      }
+
+      void armRecv(std::uint32_t id, int fd) {
+        io_uring_sqe* s = sqe();
+        io_uring_prep_recv_multishot(s, fd, nullptr, 0, 0);
+        s->flags |= IOSQE_BUFFER_SELECT;
+        s->buf_group = kBufferGroup;
+        io_uring_sqe_set_data64(s, encode(OP_RECV, id));
+      }
+
+      void armSend(std::uint32_t id, Connection& c) {
+        c.sending = true;
+        io_uring_sqe* s = sqe();
+        io_uring_prep_send(s, (int)c.conn->handle(), c.inflight.data() + c.inflightOffset,
+                           c.inflight.size() - c.inflightOffset, MSG_NOSIGNAL);
+        io_uring_sqe_set_data64(s, encode(OP_SEND, id));
+      }
+
+      int queueSend(std::uint32_t id, const char* buf, int len) override {
+        if (len <= 0)
+          return 0;
+        {
+          std::lock_guard<std::mutex> lk(m_sendMutex);
+          std::string& outbox = m_outbox[id];
+          if (outbox.empty())
+            m_dirty.push_back(id);
+          outbox.append(buf, len);
+        }
+        if (std::this_thread::get_id() != m_loopThreadId)
+          wake();
+        return len;
+      }
+
+      // moves queued payloads of idle connections into send sqes, everything goes out with the next submit
+      void flushSends() {
+        std::vector<std::uint32_t> dirty;
+        {
+          std::lock_guard<std::mutex> lk(m_sendMutex);
+          dirty.swap(m_dirty);
+        }
+
+        for (auto id: dirty) {
+          auto it = m_conns.find(id);
+          if (it == m_conns.end()) {
+            std::lock_guard<std::mutex> lk(m_sendMutex);
+            m_outbox.erase(id);
+            continue;
+          }
+          if (it->second.inflight.empty())
+            startSend(id, it->second);
+        }
+      }
+
+      void startSend(std::uint32_t id, Connection& c) {
+        {
+          std::lock_guard<std::mutex> lk(m_sendMutex);
+          auto it = m_outbox.find(id);
+          if (it == m_outbox.end() || it->second.empty())
+            return;
+          c.inflight.swap(it->second);
+          c.inflightOffset = 0;
+          m_outbox.erase(it);
+        }
+        armSend(id, c);
+      }
+
+      void run() {
+        m_loopThreadId = std::this_thread::get_id();
+        armAccept();
+        armWake();
+
+        while (!m_stopRequested) {
+          flushSends();
+          int ret = io_uring_submit_and_wait(&m_ring, 1);
+          if (ret < 0 && ret != -EINTR) {
+            std::cerr << "io_uring submit failed: " << strerror(-ret) << std::endl;
+            break;
+          }
+
+          reap();
+        }
+
+        while (!m_conns.empty())
+          drop(m_conns.begin()->first);
+        // the cancelled sends may still read their buffers until they complete
+        struct __kernel_timespec timeout {1, 0};
+        while (!m_draining.empty()) {
+          io_uring_cqe* cqe;
+          io_uring_submit(&m_ring);
+          if (io_uring_wait_cqe_timeout(&m_ring, &cqe, &timeout) < 0)
+            break;
+          reap();
+        }
+        for (auto& drained: m_draining)
+          drained.second.handler->onDisconnect();
+        thisptr::net_p::close(m_listenSock);
+        m_listenSock = INVALID_SOCKET;
+        teardownRing();
+      }
+
+      void reap() {
+        unsigned head;
+        unsigned count = 0;
+        io_uring_cqe* cqe;
+        io_uring_for_each_cqe(&m_ring, head, cqe) {
+          ++count;
+          onCompletion(cqe);
+        }
+        io_uring_cq_advance(&m_ring, count);
+      }
+
+      void onCompletion(io_uring_cqe* cqe) {
+        std::uint64_t data = io_uring_cqe_get_data64(cqe);
+        auto op = static_cast<OpType>(data >> 56);
+        auto id = static_cast<std::uint32_t>(data);
+        bool more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+
+        switch (op) {
+          case OP_ACCEPT:
+            if (cqe->res >= 0)
+              onAccept(cqe->res);
+            else if (cqe->res != -ECONNABORTED)
+              std::cerr << "s : unable to accept connection: " << strerror(-cqe->res) << std::endl;
+            if (!more && !m_stopRequested)
+              armAccept();
+            break;
+          case OP_WAKE: {
+            uint64_t count;
+            while (::read(m_wakefd, &count, sizeof(count)) > 0);
+            if (!more && !m_stopRequested)
+              armWake();
+            break;
+          }
+          case OP_RECV:
+            onRecv(id, cqe, more);
+            break;
+          case OP_SEND:
+            onSend(id, cqe->res);
+            break;
+          default:
+            break;
+        }
+      }
+
+      void onAccept(int fd) {
+        std::shared_ptr<handler_type> h = newHandler();
+        if (!h)
+        {
+          ::close(fd);
+          std::cout << "s : cannot accept connection at this time!" << std::endl;
+          return;
+        }
+
+        if (m_metrics)
+          m_metrics->add(Metrics::Accepts);
+
+        std::uint32_t id = ++m_nextId;
+        Connection c;
+        c.conn = std::make_shared<UringTcpSocket>(fd, static_cast<UringLoop*>(this), id);
+        c.conn->setMetrics(m_metrics);
+        c.handler = h;
+
+        std::shared_ptr<BlockingTcpSocket> conn = c.conn;
+        h->setTcpConn(conn);
+        h->setTcpServer(this);
+        m_conns.emplace(id, c);
+
+        armRecv(id, fd);
+        h->onConnect();
+        if (!conn->isOpen())
+          drop(id);
+      }
+
+      void onRecv(std::uint32_t id, io_uring_cqe* cqe, bool more) {
+        bool hasBuffer = (cqe->flags & IORING_CQE_F_BUFFER) != 0;
+        unsigned bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+
+        auto it = m_conns.find(id);
+        if (it != m_conns.end()) {
+          // drop erases the entry, keep the connection alive until this returns
+          std::shared_ptr<UringTcpSocket> conn = it->second.conn;
+          handler_ptr handler = it->second.handler;
+          if (cqe->res > 0 && hasBuffer) {
+            conn->recordRead(cqe->res);
+            bool bRes;
+            {
+              Metrics::Timer timer(m_metrics, Metrics::HandlerTime);
+              bRes = handler->handleData(bufferAt(bid), cqe->res);
+            }
+            if (!bRes)
+              conn->close();
+            if (!conn->isOpen())
+              drop(id);
+            else if (!more)
+              armRecv(id, (int)conn->handle());
+          } else if (cqe->res == -ENOBUFS) {
+            // buffer ring ran dry, multishot recv is terminated and has to be re-armed
+            if (!more)
+              armRecv(id, (int)conn->handle());
+          } else {
+            drop(id);
+          }
+        }
+
+        if (hasBuffer)
+          recycleBuffer(bid);
+      }
+
+      void onSend(std::uint32_t id, int res) {
+        auto it = m_conns.find(id);
+        if (it == m_conns.end()) {
+          auto drained = m_draining.find(id);
+          if (drained != m_draining.end()) {
+            handler_ptr handler = std::move(drained->second.handler);
+            m_draining.erase(drained);
+            handler->onDisconnect();
+          }
+          return;
+        }
+        Connection& c = it->second;
+        c.sending = false;
+
+        if (res < 0) {
+          drop(id);
+          return;
+        }
+
+        c.conn->recordWrite(res);
+        c.inflightOffset += res;
+        if (c.inflightOffset < c.inflight.size()) {
+          armSend(id, c);
+          return;
+        }
+        c.inflight.clear();
+        c.inflightOffset = 0;
+        startSend(id, c);
+      }
+
+      void drop(std::uint32_t id) {
+        auto it = m_conns.find(id);
+        if (it == m_conns.end())
+          return;
+        Connection c = std::move(it->second);
+        m_conns.erase(it);
+        {
+          std::lock_guard<std::mutex> lk(m_sendMutex);
+          m_outbox.erase(id);
+        }
+
+        // the ring keeps its own reference to the socket, pending operations have to be cancelled explicitly
+        for (auto op: {OP_RECV, OP_SEND}) {
+          io_uring_sqe* s = sqe();
+          io_uring_prep_cancel64(s, encode(op, id), IORING_ASYNC_CANCEL_ALL);
+          io_uring_sqe_set_data64(s, encode(OP_CANCEL, id));
+        }
+
+        if (c.conn->isOpen())
+          c.conn->close();
+        // the buffer of a send in flight is released with its cqe, the handler only hears of it then
+        if (c.sending) {
+          m_draining.emplace(id, std::move(c));
+          return;
+        }
+        c.handler->onDisconnect();
+      }
+
+      struct io_uring m_ring {};
+      struct io_uring_buf_ring* m_bufRing {nullptr};
+      std::vector<char> m_buffers;
+      bool m_ringReady {false};
+      int m_wakefd {-1};
+
+      std::thread m_loopThread;
+      std::thread::id m_loopThreadId;
+      std::atomic<bool> m_stopRequested {false};
+      SOCKET m_listenSock {INVALID_SOCKET};
+
+      std::uint32_t m_nextId {0};
+      std::unordered_map<std::uint32_t, Connection> m_conns;
+      std::unordered_map<std::uint32_t, Connection> m_draining; // dropped, waiting for their send cqe
+
+      std::mutex m_sendMutex;
+      std::unordered_map<std::uint32_t, std::string> m_outbox;
+      std::vector<std::uint32_t> m_dirty;
+
+      std::unique_ptr<EpollTcpServer<handler_type>> m_fallback;
+      std::function<std::shared_ptr<handler_type>()> m_newHandlerCallback;
+    };
+
+    template <typename H>
+    using UringTcpServer = TcpServer<UringTcpSocket, H>;
+  }
+}
+
+#endif
+
+#endif //NetLib_URINGSERVER_H
@@ -0,0 +1,62 @@
+#ifndef NetLib_ZEROCOPY_H
+#define NetLib_ZEROCOPY_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <net_p.h>
+
+namespace thisptr {
+  namespace net {
+
+    // Keeps the payloads of MSG_ZEROCOPY sends alive until the kernel reports through the socket error queue
+    // that it no longer reads from them. Every send that returned > 0 takes the next id, the kernel numbers
+    // its notifications the same way. Not thread-safe, callers lock around it.
+    class ZeroCopyTracker {
+    public:
+      std::uint32_t nextId() { return m_nextId++; }
+
+      // holds payload until the notification covering id arrived
+      void hold(std::uint32_t id, std::string&& payload);
+      // same for a payload shared with other sockets, the reference is dropped once the kernel is done with it
+      void hold(std::uint32_t id, std::shared_ptr<const std::string> payload);
+
+      // reads every notification queued on sock without blocking and releases the payloads they cover,
+      // returns how many were released or NETE_SocketError
+      int reap(SOCKET sock);
+
+      // drops everything, only safe once the socket is gone
+      void clear() { m_held.clear(); }
+
+      // takes over what tracker still holds so the owner can close sock without waiting. a duplicate of sock
+      // stays open to read the notifications, sock is shut down so the peer still sees the end of the stream.
+      // returns false if sock cannot be kept, the payloads are then the caller's to release
+      static bool retire(SOCKET sock, ZeroCopyTracker&& tracker);
+      // releases retired payloads the kernel is done with and closes their duplicates, returns how many remain.
+      // a background thread does this while there are any, calling it only speeds that up
+      static std::size_t reapRetired();
+
+      std::size_t size() const { return m_held.size(); }
+      bool empty() const { return m_held.empty(); }
+      // completions for which the kernel copied after all, e.g. on loopback or without scatter-gather support
+      std::size_t copied() const { return m_copied; }
+      std::size_t completed() const { return m_completed; }
+
+    private:
+      struct Held {
+        std::uint32_t id;
+        bool done;
+        std::string payload;
+        std::shared_ptr<const std::string> shared;
+      };
+
+      std::deque<Held> m_held;
+      std::uint32_t m_nextId {0};
+      std::size_t m_copied {0};
+      std::size_t m_completed {0};
+    };
+  }
+}
+
+#endif //NetLib_ZEROCOPY_H
@@ -12,6 +12,16 @@
   #include <netinet/tcp.h>
   #include <netinet/ip.h>
   #include <netdb.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <cerrno>
+  #include <cstring>
+
+  // keep the same socket handle width as winsock, BlockingTcpSocket stores it as unsigned long long
+  typedef unsigned long long SOCKET;
+  #ifndef INVALID_SOCKET
+    #define INVALID_SOCKET (SOCKET)(~0)
+  #endif
 #endif
 
 #include <map>
@@ -49,12 +59,12 @@ namespace thisptr {
     std::string lastErrorString();
     int close(SOCKET sock);
 #else
-    int initialize() { return 0; }
-    int cleanup() { return 0; }
+    inline int initialize() { return 0; }
+    inline int cleanup() { return 0; }
 
-    int setBlocking(SOCKET socket, bool isBlocking) {
+    inline int setBlocking(SOCKET socket, bool isBlocking) {
       int nCurFlag;
-      if ((nCurFlag = fcntl(m_socket, F_GETFL)) < 0)
+      if ((nCurFlag = fcntl(socket, F_GETFL)) < 0)
       {
           return nCurFlag;
       }
@@ -64,10 +74,10 @@ namespace thisptr {
       else
         nCurFlag |= O_NONBLOCK;
 
-      return fcntl(m_socket, F_SETFL, nCurFlag);
+      return fcntl(socket, F_SETFL, nCurFlag);
     }
 
-    NetSocketError lastError() {
+    inline NetSocketError lastError() {
       int err = errno;
 
       std::map<int, NetSocketError>::iterator it;
@@ -77,23 +87,46 @@ namespace thisptr {
       return NETE_Unknown;
     }
 
-    std::string lastErrorString() {
+    inline std::string lastErrorString() {
       return std::string(strerror(errno));
     }
 
-    int close(SOCKET sock) {
+    inline int close(SOCKET sock) {
       int iResult = ::close(sock);
       return iResult;
     }
 #endif
 
-    struct addrinfo* addressinfo(const char* address, const char* port);
-    int connect(SOCKET& sock, const char* address, const char* port);
+    struct addrinfo* addressinfo(const char* address, const char* port, int socktype = SOCK_STREAM);
+    int connect(SOCKET& sock, const char* address, const char* port, int socktype = SOCK_STREAM);
+    // tcp connect that races the resolved addresses instead of trying them one after another (rfc 8305):
+    // families alternate, a new non-blocking attempt starts every attemptDelayMs or as soon as the others
+    // failed, the first to complete wins. returns NETE_Timedout once timeoutMs passed, zero waits for the kernel
+    int connectTimeout(SOCKET& sock, const char* address, const char* port, long timeoutMs, long attemptDelayMs = 250);
+    // same for addresses resolved beforehand, e.g. cached ones
+    int connectTimeout(SOCKET& sock, const struct addrinfo* addresses, long timeoutMs, long attemptDelayMs = 250);
     int setsockopt(SOCKET sock, int opt, const void* val, int size);
+    // SO_RCVTIMEO / SO_SNDTIMEO in milliseconds, zero blocks forever
+    int setTimeout(SOCKET sock, int opt, long milliseconds);
     int send(SOCKET sock, const char* buffer, int len);
     int recv(SOCKET sock, char* buffer, int len);
+    int peek(SOCKET sock, bool wait = true);
+    // writes up to len bytes of the file starting at offset without copying them through user memory,
+    // returns the bytes sent (possibly fewer on a non-blocking socket) or NETE_SocketError
+    long long sendFile(SOCKET sock, int fd, long long offset, std::size_t len);
+    // opts the socket into MSG_ZEROCOPY (linux 4.14+), fails where that is not supported
+    int enableZeroCopy(SOCKET sock);
+    // send that transmits straight from buffer, which has to stay untouched until readZeroCopy
+    // reported the call as completed. every call that returned > 0 is numbered, starting at zero
+    int sendZeroCopy(SOCKET sock, const char* buffer, int len);
+    // reads one completion for the sends lo..hi from the error queue without blocking, returns 1 if there was
+    // one, 0 if not or NETE_SocketError. copied tells that the kernel fell back to copying the data
+    int readZeroCopy(SOCKET sock, uint32_t& lo, uint32_t& hi, bool& copied);
+    // waits up to timeoutMs for completions to arrive, returns 1 if there are some
+    int waitZeroCopy(SOCKET sock, int timeoutMs);
     int shutdown(SOCKET sock, char c);
     int listen(SOCKET& sock, const char* address, const char* port);
+    int bindDatagram(SOCKET& sock, const char* address, const char* port);
     SOCKET accept(SOCKET sock);
   }
 
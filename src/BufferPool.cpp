@@ -0,0 +1,94 @@
+#include <BufferPool.h>
+#include <algorithm>
+#include <cstring>
+
+using namespace thisptr::net;
+
+BufferPool::BufferPool(std::size_t slabSize, std::size_t capacity) :
+m_slabSize(slabSize),
+m_slabs([slabSize]() { return new char[slabSize]; }, [](char* slab) { delete[] slab; }, capacity) {
+}
+
+BufferPool& BufferPool::shared() {
+  static BufferPool pool;
+  return pool;
+}
+
+BufferPool::Slab BufferPool::acquire(std::size_t minSize) {
+  Slab slab;
+  m_outstanding.fetch_add(1, std::memory_order_relaxed);
+  if (minSize <= m_slabSize && (slab.data = m_slabs.pop()) != nullptr) {
+    slab.size = m_slabSize;
+    slab.pooled = true;
+    return slab;
+  }
+
+  slab.size = std::max(minSize, m_slabSize);
+  slab.data = new char[slab.size];
+  return slab;
+}
+
+void BufferPool::release(Slab& slab) {
+  if (!slab.data)
+    return;
+  m_outstanding.fetch_sub(1, std::memory_order_relaxed);
+  if (slab.pooled)
+    m_slabs.push(slab.data);
+  else
+    delete[] slab.data;
+  slab = Slab();
+}
+
+void SlabBuffer::setPool(BufferPool* pool) {
+  if (pool == m_pool)
+    return;
+  if (!isLent()) {
+    m_pool = pool;
+    return;
+  }
+
+  // data is still pending, move it over into a slab of the new pool
+  BufferPool::Slab slab = pool->acquire(size());
+  memcpy(slab.data, data(), size());
+  m_pool->release(m_slab);
+  m_slab = slab;
+  m_end = size();
+  m_begin = 0;
+  m_pool = pool;
+}
+
+char* SlabBuffer::prepare(std::size_t n) {
+  if (!m_slab.data) {
+    m_slab = m_pool->acquire(n);
+    m_begin = m_end = 0;
+    return m_slab.data;
+  }
+
+  if (m_slab.size - m_end >= n)
+    return m_slab.data + m_end;
+
+  std::size_t len = size();
+  if (m_slab.size - len >= n) {
+    memmove(m_slab.data, data(), len);
+  } else {
+    BufferPool::Slab bigger = m_pool->acquire(std::max(len + n, m_slab.size * 2));
+    memcpy(bigger.data, data(), len);
+    m_pool->release(m_slab);
+    m_slab = bigger;
+  }
+  m_begin = 0;
+  m_end = len;
+  return m_slab.data + m_end;
+}
+
+void SlabBuffer::commit(std::size_t n) {
+  m_end = std::min(m_end + n, m_slab.size);
+}
+
+void SlabBuffer::consume(std::size_t n) {
+  m_begin = std::min(m_begin + n, m_end);
+  if (m_begin == m_end) {
+    m_pool->release(m_slab);
+    m_begin = m_end = 0;
+  }
+}
@@ -0,0 +1,65 @@
+#include <Framing.h>
+
+using namespace thisptr::net;
+
+constexpr long long FrameCodec::kFrameTooLarge;
+
+std::string FrameCodec::frame(const char* data, std::size_t len) const {
+  char header[10];
+  std::size_t headerLen = writeHeader(header, len);
+
+  std::string framed;
+  framed.reserve(headerLen + len);
+  framed.append(header, headerLen);
+  framed.append(data, len);
+  return framed;
+}
+
+std::size_t FrameCodec::writeHeader(char* out, std::size_t len) const {
+  if (m_prefix == Prefix::Fixed32) {
+    auto value = static_cast<std::uint32_t>(len);
+    out[0] = static_cast<char>((value >> 24) & 0xff);
+    out[1] = static_cast<char>((value >> 16) & 0xff);
+    out[2] = static_cast<char>((value >> 8) & 0xff);
+    out[3] = static_cast<char>(value & 0xff);
+    return 4;
+  }
+
+  std::size_t i = 0;
+  auto value = static_cast<std::uint64_t>(len);
+  do {
+    auto byte = static_cast<std::uint8_t>(value & 0x7f);
+    value >>= 7;
+    if (value)
+      byte |= 0x80;
+    out[i++] = static_cast<char>(byte);
+  } while (value);
+  return i;
+}
+
+int FrameCodec::readHeader(const char* data, std::size_t len, std::size_t& frameLen) const {
+  const auto* bytes = reinterpret_cast<const std::uint8_t*>(data);
+
+  if (m_prefix == Prefix::Fixed32) {
+    if (len < 4)
+      return 0;
+    std::uint32_t value = (std::uint32_t(bytes[0]) << 24) | (std::uint32_t(bytes[1]) << 16) |
+                          (std::uint32_t(bytes[2]) << 8) | std::uint32_t(bytes[3]);
+    if (value > m_maxFrameSize)
+      return -1;
+    frameLen = value;
+    return 4;
+  }
+
+  std::uint64_t value = 0;
+  for (std::size_t i = 0; i < len && i < 10; ++i) {
+    value |= std::uint64_t(bytes[i] & 0x7f) << (7 * i);
+    if (value > m_maxFrameSize)
+      return -1;
+    if (!(bytes[i] & 0x80)) {
+      frameLen = static_cast<std::size_t>(value);
+      return static_cast<int>(i + 1);
+    }
+  }
+  return len >= 10 ? -1 : 0;
+}
@@ -0,0 +1,138 @@
+#include <Metrics.h>
+
+#include <algorithm>
+#include <sstream>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace thisptr::net;
+
+constexpr std::size_t Metrics::kBuckets;
+constexpr std::size_t Metrics::kShards;
+
+namespace {
+  std::size_t bucketOf(std::uint64_t value) {
+    if (value == 0)
+      return 0;
+#ifdef _MSC_VER
+    unsigned long msb;
+    _BitScanReverse64(&msb, value);
+    return (std::size_t)msb + 1;
+#else
+    return (std::size_t)(64 - __builtin_clzll(value));
+#endif
+  }
+}
+
+Metrics& Metrics::global() {
+  static Metrics metrics;
+  return metrics;
+}
+
+Metrics::Shard& Metrics::shard() {
+  // threads are spread over the shards in the order they first report
+  static std::atomic<std::size_t> nextShard {0};
+  thread_local std::size_t index = nextShard.fetch_add(1, std::memory_order_relaxed) % kShards;
+  return m_shards[index];
+}
+
+void Metrics::record(Distribution distribution, std::uint64_t value) {
+  Shard& s = shard();
+  s.buckets[distribution][bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+  s.sums[distribution].fetch_add(value, std::memory_order_relaxed);
+
+  std::uint64_t max = s.maxima[distribution].load(std::memory_order_relaxed);
+  while (value > max && !s.maxima[distribution].compare_exchange_weak(max, value, std::memory_order_relaxed));
+}
+
+MetricsSnapshot Metrics::snapshot() const {
+  MetricsSnapshot snapshot;
+  std::uint64_t counters[kCounterCount] = {};
+
+  for (auto& s: m_shards) {
+    for (std::size_t c = 0; c < kCounterCount; ++c)
+      counters[c] += s.counters[c].load(std::memory_order_relaxed);
+
+    for (std::size_t d = 0; d < kDistributionCount; ++d) {
+      MetricsSnapshot::Distribution& dist = snapshot.distributions[d];
+      for (std::size_t b = 0; b < kBuckets; ++b) {
+        std::uint64_t n = s.buckets[d][b].load(std::memory_order_relaxed);
+        dist.buckets[b] += n;
+        dist.count += n;
+      }
+      dist.sum += s.sums[d].load(std::memory_order_relaxed);
+      dist.max = std::max(dist.max, s.maxima[d].load(std::memory_order_relaxed));
+    }
+  }
+
+  // the gauges are kept as wrapping sums of +1/-1, so the total converts back to a signed value
+  for (std::size_t c = 0; c < kCounterCount; ++c)
+    snapshot.counters[c] = (std::int64_t)counters[c];
+  return snapshot;
+}
+
+void Metrics::reset() {
+  for (auto& s: m_shards) {
+    // the gauges keep their level
+    for (std::size_t c = 0; c < kCounterCount; ++c)
+      if (c != ActiveConnections)
+        s.counters[c].store(0, std::memory_order_relaxed);
+
+    for (std::size_t d = 0; d < kDistributionCount; ++d) {
+      for (auto& bucket: s.buckets[d])
+        bucket.store(0, std::memory_order_relaxed);
+      s.sums[d].store(0, std::memory_order_relaxed);
+      s.maxima[d].store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+const char* Metrics::name(Counter counter) {
+  static const char* names[kCounterCount] = {
+      "accepts", "active_connections", "bytes_in", "bytes_out", "reads", "writes"
+  };
+  return names[counter];
+}
+
+const char* Metrics::name(Distribution distribution) {
+  static const char* names[kDistributionCount] = {
+      "read_size", "write_size", "queue_depth", "handler_time_ns"
+  };
+  return names[distribution];
+}
+
+std::uint64_t MetricsSnapshot::Distribution::percentile(double p) const {
+  if (count == 0)
+    return 0;
+  auto rank = (std::uint64_t)(p / 100.0 * (double)count + 0.5);
+  rank = std::max<std::uint64_t>(1, std::min(rank, count));
+
+  std::uint64_t seen = 0;
+  for (std::size_t b = 0; b < Metrics::kBuckets; ++b) {
+    seen += buckets[b];
+    if (seen >= rank) {
+      std::uint64_t upper = b == 0 ? 0 : (b == 64 ? ~0ull : (1ull << b) - 1);
+      return std::min(upper, max);
+    }
+  }
+  return max;
+}
+
+std::string MetricsSnapshot::toJson() const {
+  std::stringstream ss;
+  ss << "{";
+  for (std::size_t c = 0; c < Metrics::kCounterCount; ++c)
+    ss << "\"" << Metrics::name((Metrics::Counter)c) << "\": " << counters[c] << ", ";
+
+  for (std::size_t d = 0; d < Metrics::kDistributionCount; ++d) {
+    const Distribution& dist = distributions[d];
+    ss << "\"" << Metrics::name((Metrics::Distribution)d) << "\": {\"count\": " << dist.count
+       << ", \"mean\": " << dist.mean() << ", \"p50\": " << dist.percentile(50)
+       << ", \"p99\": " << dist.percentile(99) << ", \"max\": " << dist.max << "}"
+       << (d + 1 < Metrics::kDistributionCount ? ", " : "");
+  }
+  ss << "}";
+  return ss.str();
+}
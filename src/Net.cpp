@@ -3,18 +3,91 @@
 using namespace thisptr::net;
 
 BlockingTcpSocket::~BlockingTcpSocket() {
-  if (m_sock != -1)
+  if (m_sock != -1) {
+    retireZeroCopy();
     thisptr::net_p::close(m_sock);
+  }
+  countClose();
   thisptr::net_p::cleanup();
 }
 
 BlockingTcpSocket::BlockingTcpSocket(unsigned long long int sock) : m_sock(sock) {
   thisptr::net_p::initialize();
+  if (m_sock != INVALID_SOCKET)
+    countOpen();
 }
 
 bool BlockingTcpSocket::connect(const std::string& address, const std::string& port) {
-  int res = thisptr::net_p::connect(m_sock, address.c_str(), port.c_str());
-  return res != thisptr::net_p::NETE_SocketError;
+  int res;
+  if (m_resolver) {
+    ResolverCache::Entry addresses = m_resolver->resolve(address, port);
+    res = thisptr::net_p::connectTimeout(m_sock, addresses ? addresses->addresses() : nullptr,
+                                         (long)m_connectTimeout.count(), (long)m_attemptDelay.count());
+    // the name may have moved elsewhere, look it up again next time. a timeout says nothing about the addresses
+    if (res != thisptr::net_p::NETE_Success && res != thisptr::net_p::NETE_Timedout && addresses)
+      m_resolver->erase(address, port);
+  } else {
+    res = thisptr::net_p::connectTimeout(m_sock, address.c_str(), port.c_str(),
+                                         (long)m_connectTimeout.count(), (long)m_attemptDelay.count());
+  }
+  if (res != thisptr::net_p::NETE_Success)
+    return false;
+  countOpen();
+  return true;
+}
+
+void BlockingTcpSocket::setMetrics(Metrics* metrics) {
+  // the connection moves over to the new sink
+  bool bCounted = m_counted;
+  countClose();
+  m_metrics = metrics;
+  if (bCounted)
+    countOpen();
+}
+
+void BlockingTcpSocket::recordRead(std::size_t len) {
+  m_stats.onRead(len);
+  if (!m_metrics)
+    return;
+  m_metrics->add(Metrics::Reads);
+  m_metrics->add(Metrics::BytesIn, (std::int64_t)len);
+  m_metrics->record(Metrics::ReadSize, len);
+}
+
+void BlockingTcpSocket::recordWrite(std::size_t len) {
+  m_stats.onWrite(len);
+  if (!m_metrics)
+    return;
+  m_metrics->add(Metrics::Writes);
+  m_metrics->add(Metrics::BytesOut, (std::int64_t)len);
+  m_metrics->record(Metrics::WriteSize, len);
+}
+
+void BlockingTcpSocket::countOpen() {
+  if (m_counted)
+    return;
+  m_counted = true;
+  if (m_metrics)
+    m_metrics->add(Metrics::ActiveConnections);
+}
+
+void BlockingTcpSocket::countClose() {
+  if (!m_counted)
+    return;
+  m_counted = false;
+  if (m_metrics)
+    m_metrics->add(Metrics::ActiveConnections, -1);
+}
+
+bool BlockingTcpSocket::setReadTimeout(std::chrono::milliseconds timeout) {
+  if (thisptr::net_p::setTimeout(m_sock, SO_RCVTIMEO, (long)timeout.count()) != 0)
+    return false;
+  m_readTimeout = timeout.count() > 0;
+  return true;
+}
+
+bool BlockingTcpSocket::setWriteTimeout(std::chrono::milliseconds timeout) {
+  return thisptr::net_p::setTimeout(m_sock, SO_SNDTIMEO, (long)timeout.count()) == 0;
 }
 
 int BlockingTcpSocket::recv(char *buf, int len) {
@@ -22,7 +95,21 @@ int BlockingTcpSocket::recv(char *buf, int len) {
   if ( iRes < 0 ) {
     thisptr::net_p::NetSocketError err = thisptr::net_p::lastError();
     if (err == thisptr::net_p::NETE_Wouldblock)
-      return thisptr::net_p::NETE_Success;
+      return m_readTimeout ? thisptr::net_p::NETE_Timedout : thisptr::net_p::NETE_Success;
+    close();
+    return err;
+  } else if ( iRes == 0 )
+    return thisptr::net_p::NETE_Notconnected;
+  recordRead(iRes);
+  return iRes;
+}
+
+int BlockingTcpSocket::waitReadable() {
+  int iRes = thisptr::net_p::peek(m_sock);
+  if ( iRes < 0 ) {
+    thisptr::net_p::NetSocketError err = thisptr::net_p::lastError();
+    if (err == thisptr::net_p::NETE_Wouldblock)
+      return m_readTimeout ? thisptr::net_p::NETE_Timedout : thisptr::net_p::NETE_Success;
     close();
     return err;
   } else if ( iRes == 0 )
@@ -30,11 +117,19 @@ int BlockingTcpSocket::recv(char *buf, int len) {
   return iRes;
 }
 
+bool BlockingTcpSocket::isHealthy() {
+  if (m_sock == INVALID_SOCKET)
+    return false;
+  int iRes = thisptr::net_p::peek(m_sock, false);
+  return iRes < 0 && thisptr::net_p::lastError() == thisptr::net_p::NETE_Wouldblock;
+}
+
 int BlockingTcpSocket::send(const char *buf) {
   int iRes = thisptr::net_p::send(m_sock, buf, strlen(buf));
   if (iRes == thisptr::net_p::NETE_SocketError) {
     close();
-  }
+  } else
+    recordWrite(iRes);
   return iRes;
 }
 
@@ -42,18 +137,113 @@ int BlockingTcpSocket::send(const char *buf, int len) {
   int iRes = thisptr::net_p::send(m_sock, buf, len);
   if (iRes == thisptr::net_p::NETE_SocketError) {
     close();
-  }
+  } else
+    recordWrite(iRes);
   return iRes;
 }
 
+bool BlockingTcpSocket::setZeroCopyThreshold(std::size_t threshold) {
+  if (threshold > 0 && !m_zeroCopyEnabled) {
+    if (thisptr::net_p::enableZeroCopy(m_sock) != 0)
+      return false;
+    m_zeroCopyEnabled = true;
+  }
+  m_zeroCopyThreshold = threshold;
+  return true;
+}
+
+int BlockingTcpSocket::send(std::string&& payload) {
+  if (m_zeroCopyThreshold == 0 || payload.size() < m_zeroCopyThreshold)
+    return send(payload.data(), (int)payload.size());
+
+  m_zeroCopy.reap(m_sock);
+  std::size_t sent = 0;
+  bool bZeroCopied = false;
+  std::uint32_t id = 0;
+  while (sent < payload.size()) {
+    int len = (int)(payload.size() - sent);
+    int iRes = thisptr::net_p::sendZeroCopy(m_sock, payload.data() + sent, len);
+    if (iRes < 0 && errno == ENOBUFS) // no room left for more notifications, copy this part
+      iRes = thisptr::net_p::send(m_sock, payload.data() + sent, len);
+    else if (iRes > 0) {
+      id = m_zeroCopy.nextId();
+      bZeroCopied = true;
+    }
+
+    if (iRes < 0) {
+      thisptr::net_p::NetSocketError err = thisptr::net_p::lastError();
+      if (err == thisptr::net_p::NETE_Interrupted)
+        continue;
+      close();
+      return err;
+    }
+    recordWrite(iRes);
+    sent += iRes;
+  }
+
+  // tcp completes sends in order, so holding the payload under the id of its last part is enough
+  if (bZeroCopied)
+    m_zeroCopy.hold(id, std::move(payload));
+  return (int)sent;
+}
+
+bool BlockingTcpSocket::flushZeroCopy(std::chrono::milliseconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (m_zeroCopy.reap(m_sock) >= 0 && !m_zeroCopy.empty()) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    if (left.count() <= 0 || thisptr::net_p::waitZeroCopy(m_sock, (int)left.count()) < 0)
+      break;
+  }
+  return m_zeroCopy.empty();
+}
+
+long long BlockingTcpSocket::sendFile(int fd, long long offset, std::size_t length) {
+  long long sent = 0;
+  while ((std::size_t)sent < length) {
+    long long iRes = thisptr::net_p::sendFile(m_sock, fd, offset + sent, length - (std::size_t)sent);
+    if (iRes == thisptr::net_p::NETE_SocketError) {
+      thisptr::net_p::NetSocketError err = thisptr::net_p::lastError();
+      if (err == thisptr::net_p::NETE_Interrupted)
+        continue;
+      close();
+      return err;
+    } else if (iRes == 0)
+      break; // the file ended early
+    recordWrite((std::size_t)iRes);
+    sent += iRes;
+  }
+  return sent;
+}
+
+void BlockingTcpSocket::retireZeroCopy() {
+  // the kernel may still transmit from payloads it has not released, they must not be freed before that.
+  // rather than waiting here they outlive the socket, earlier ones are released on the way
+  ZeroCopyTracker::reapRetired();
+  if (m_zeroCopy.empty() || m_sock == INVALID_SOCKET)
+    return;
+  m_zeroCopy.reap(m_sock);
+  if (!m_zeroCopy.empty() && !ZeroCopyTracker::retire(m_sock, std::move(m_zeroCopy)))
+    flushZeroCopy(std::chrono::seconds(1));
+  m_zeroCopy = ZeroCopyTracker();
+}
+
 bool BlockingTcpSocket::close() {
+  retireZeroCopy();
   if (thisptr::net_p::close(m_sock) == 0) {
     m_sock = -1;
+    countClose();
     return true;
   }
   return false;
 }
 
+bool BlockingTcpSocket::shutdown() {
+  if (m_sock == INVALID_SOCKET)
+    return false;
+  // SHUT_RDWR and SD_BOTH, net_p::shutdown would close the handle on failure
+  return ::shutdown((SOCKET)m_sock, 2) == 0;
+}
+
 bool BlockingTcpSocket::bind(const std::string &address, const std::string &port) {
   int err = thisptr::net_p::listen(m_sock, address.c_str(), port.c_str());
   bool bRes = (err == thisptr::net_p::NETE_Success && m_sock != INVALID_SOCKET);
@@ -72,17 +262,37 @@ std::shared_ptr<BlockingTcpSocket> BlockingTcpSocket::accept() {
 void BlockingTcpHandler::operator()() {
   onConnect();
   while(true) {
-    char buffer[256] = {0};
-    int res = m_conn->recv(buffer, 256);
-    if (res < 0 && res != thisptr::net_p::NETE_Notconnected) {
+    // only borrow a receive slab once there is something to read
+    int res = m_conn->waitReadable();
+    if (res > 0) {
+      BufferPool::Slab slab = BufferPool::shared().acquire();
+      res = m_conn->recv(slab.data, (int)slab.size);
+      if (res > 0) {
+        bool bRes;
+        {
+          Metrics::Timer timer(m_conn->metrics(), Metrics::HandlerTime);
+          bRes = handleData(slab.data, res);
+        }
+        BufferPool::shared().release(slab);
+        if (bRes)
+          continue;
+        std::cout << " : malformed frame, closing connection" << std::endl;
+        m_conn->close();
+        break;
+      }
+      BufferPool::shared().release(slab);
+    }
+
+    if (res == thisptr::net_p::NETE_Timedout) {
+      std::cout << " : read timed out, closing connection" << std::endl;
+      m_conn->close();
+      break;
+    } else if (res < 0 && res != thisptr::net_p::NETE_Notconnected) {
       std::cout << " : error occured, res: " << res << std::endl;
       break;
     } else if (res == thisptr::net_p::NETE_Notconnected) {
       std::cout << " : connection closed" << std::endl;
       break;
-    } else {
-      std::string data(buffer, res);
-      onMessage(data);
     }
   }
   onDisconnect();
@@ -94,6 +304,43 @@ void BlockingTcpHandler::setTcpServer(TcpServerBase *server) {
 
 void BlockingTcpHandler::setTcpConn(std::shared_ptr<net::BlockingTcpSocket>& conn) {
   m_conn = conn;
+  m_partial.clear();
+}
+
+void BlockingTcpHandler::setFrameCodec(const FrameCodec& codec) {
+  m_codec = codec;
+  m_framing = true;
+}
+
+bool BlockingTcpHandler::handleData(const char* data, std::size_t len) {
+  if (!m_framing) {
+    onMessage(std::string(data, len));
+    return true;
+  }
+
+  // frames that arrived in one piece are delivered straight from the receive buffer,
+  // only a trailing partial frame is kept around until the rest of it arrives
+  bool bBuffered = !m_partial.empty();
+  if (bBuffered) {
+    m_partial.append(data, len);
+    data = m_partial.data();
+    len = m_partial.size();
+  }
+
+  long long used = m_codec.parse(data, len, [this](const char* frame, std::size_t size) {
+    onFrame(frame, size);
+    return m_conn->isOpen();
+  });
+  if (used == FrameCodec::kFrameTooLarge) {
+    m_partial.clear();
+    return false;
+  }
+
+  if (bBuffered)
+    m_partial.erase(0, (std::size_t)used);
+  else
+    m_partial.assign(data + used, len - used);
+  return true;
 }
 
 void BlockingTcpHandler::onConnect() {
@@ -105,3 +352,7 @@ void BlockingTcpHandler::onDisconnect() {
 void BlockingTcpHandler::onMessage(std::string data) {
   std::cerr << "if you can read this, it means you should think about handling connections!" << std::endl;
 }
+
+void BlockingTcpHandler::onFrame(const char* data, std::size_t len) {
+  std::cerr << "if you can read this, it means you should think about handling frames!" << std::endl;
+}
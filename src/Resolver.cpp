@@ -0,0 +1,120 @@
+#include <Resolver.h>
+#include <algorithm>
+#include <cstring>
+
+using namespace thisptr::net;
+
+ResolvedAddresses::ResolvedAddresses(const struct addrinfo* list) {
+  for (const struct addrinfo* ptr = list; ptr != nullptr; ptr = ptr->ai_next)
+    add(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol, ptr->ai_addr, ptr->ai_addrlen);
+}
+
+void ResolvedAddresses::add(int family, int socktype, int protocol, const struct sockaddr* addr, std::size_t len) {
+  if (len > sizeof(struct sockaddr_storage))
+    return;
+  struct addrinfo info{};
+  info.ai_family = family;
+  info.ai_socktype = socktype;
+  info.ai_protocol = protocol;
+  info.ai_addrlen = (socklen_t)len;
+  m_chain.push_back(info);
+  m_storage.emplace_back();
+  std::memcpy(&m_storage.back(), addr, len);
+
+  // both vectors may have moved, so link everything again
+  for (std::size_t i = 0; i < m_chain.size(); ++i) {
+    m_chain[i].ai_addr = reinterpret_cast<struct sockaddr*>(&m_storage[i]);
+    m_chain[i].ai_next = i + 1 < m_chain.size() ? &m_chain[i + 1] : nullptr;
+  }
+}
+
+ResolverCache& ResolverCache::global() {
+  static ResolverCache cache;
+  return cache;
+}
+
+void ResolverCache::setTtl(std::chrono::milliseconds ttl) {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  m_ttl = ttl;
+}
+
+void ResolverCache::setCapacity(std::size_t capacity) {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  m_capacity = capacity;
+}
+
+ResolverCache::Entry ResolverCache::find(const std::string& host, const std::string& port) {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  auto it = m_entries.find(key(host, port));
+  if (it == m_entries.end())
+    return nullptr;
+  if (it->second.expires <= clock::now()) {
+    m_entries.erase(it);
+    return nullptr;
+  }
+  return it->second.addresses;
+}
+
+void ResolverCache::store(const std::string& host, const std::string& port, Entry addresses) {
+  if (!addresses || addresses->empty())
+    return;
+  std::lock_guard<std::mutex> lk(m_mutex);
+  if (m_capacity == 0 || m_ttl.count() <= 0)
+    return;
+
+  clock::time_point now = clock::now();
+  std::string k = key(host, port);
+  if (m_entries.size() >= m_capacity && m_entries.find(k) == m_entries.end()) {
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+      if (it->second.expires <= now)
+        it = m_entries.erase(it);
+      else
+        ++it;
+    }
+    if (m_entries.size() >= m_capacity) {
+      m_entries.erase(std::min_element(m_entries.begin(), m_entries.end(),
+                                       [](const std::pair<const std::string, Cached>& a,
+                                          const std::pair<const std::string, Cached>& b) {
+                                         return a.second.expires < b.second.expires;
+                                       }));
+    }
+  }
+  m_entries[k] = {std::move(addresses), now + m_ttl};
+}
+
+void ResolverCache::erase(const std::string& host, const std::string& port) {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  m_entries.erase(key(host, port));
+}
+
+void ResolverCache::clear() {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  m_entries.clear();
+}
+
+std::size_t ResolverCache::size() {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  return m_entries.size();
+}
+
+ResolverCache::Entry ResolverCache::resolve(const std::string& host, const std::string& port) {
+  Entry addresses = find(host, port);
+  if (addresses)
+    return addresses;
+
+  struct addrinfo* result = thisptr::net_p::addressinfo(host.c_str(), port.c_str());
+  if (result == nullptr)
+    return nullptr;
+  addresses = std::make_shared<const ResolvedAddresses>(result);
+  freeaddrinfo(result);
+  store(host, port, addresses);
+  return addresses;
+}
+
+std::string ResolverCache::key(const std::string& host, const std::string& port) {
+  // a nul can appear in neither, unlike ':' in ipv6 literals
+  std::string k(host);
+  k.push_back('\0');
+  k += port;
+  return k;
+}
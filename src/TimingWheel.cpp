@@ -0,0 +1,162 @@
+#include <TimingWheel.h>
+
+using namespace thisptr::net;
+
+constexpr int TimingWheel::kLevels;
+constexpr int TimingWheel::kSlotBits;
+constexpr int TimingWheel::kSlots;
+
+void TimingWheel::Timer::cancel() {
+  if (isArmed() && m_wheel)
+    m_wheel->cancel(*this);
+}
+
+TimingWheel::TimingWheel(std::chrono::milliseconds tick) :
+m_tick(tick.count() > 0 ? tick : std::chrono::milliseconds(1)), m_start(clock::now())
+{
+  for (auto& level: m_slots)
+    for (auto& head: level)
+      head.prev = head.next = &head;
+}
+
+TimingWheel::~TimingWheel() {
+  // leave the timers disarmed, their owners may outlive the wheel
+  for (auto& level: m_slots)
+    for (auto& head: level) {
+      while (head.next != &head) {
+        Node* node = head.next;
+        unlink(*node);
+        static_cast<Timer*>(node)->m_wheel = nullptr;
+      }
+    }
+}
+
+void TimingWheel::link(Node& head, Node& node) {
+  node.prev = head.prev;
+  node.next = &head;
+  head.prev->next = &node;
+  head.prev = &node;
+}
+
+void TimingWheel::unlink(Node& node) {
+  node.prev->next = node.next;
+  node.next->prev = node.prev;
+  node.prev = node.next = nullptr;
+}
+
+void TimingWheel::arm(Timer& timer, std::chrono::milliseconds timeout, Callback callback) {
+  timer.m_callback = std::move(callback);
+  rearm(timer, timeout);
+}
+
+void TimingWheel::rearm(Timer& timer, std::chrono::milliseconds timeout) {
+  if (timer.isArmed())
+    cancel(timer);
+
+  // rounded up, a timer never fires early. the current tick is already partly over, so one more is added
+  std::uint64_t ticks = (std::uint64_t)((timeout.count() + m_tick.count() - 1) / m_tick.count()) + 1;
+  timer.m_wheel = this;
+  timer.m_expiry = m_now + ticks;
+  insert(timer);
+  m_count++;
+}
+
+void TimingWheel::cancel(Timer& timer) {
+  if (!timer.isArmed())
+    return;
+  unlink(timer);
+  m_count--;
+}
+
+void TimingWheel::insert(Timer& timer) {
+  std::uint64_t delta = timer.m_expiry > m_now ? timer.m_expiry - m_now : 0;
+  const std::uint64_t range = 1ull << (kSlotBits * kLevels);
+  if (delta >= range) {
+    timer.m_expiry = m_now + range - 1;
+    delta = range - 1;
+  }
+
+  int level = 0;
+  while (level < kLevels - 1 && delta >= (1ull << (kSlotBits * (level + 1))))
+    level++;
+  int slot = (int)((timer.m_expiry >> (kSlotBits * level)) & (kSlots - 1));
+  link(m_slots[level][slot], timer);
+}
+
+void TimingWheel::cascade(int level, int slot) {
+  // the slot now lies within reach of the lower levels, spread its timers over them
+  Node pending;
+  pending.prev = pending.next = &pending;
+  Node& head = m_slots[level][slot];
+  while (head.next != &head) {
+    Node* node = head.next;
+    unlink(*node);
+    link(pending, *node);
+  }
+
+  while (pending.next != &pending) {
+    Node* node = pending.next;
+    unlink(*node);
+    insert(*static_cast<Timer*>(node));
+  }
+}
+
+std::size_t TimingWheel::expire(int slot) {
+  // detached first, callbacks may arm or cancel other timers of this slot
+  Node pending;
+  pending.prev = pending.next = &pending;
+  Node& head = m_slots[0][slot];
+  while (head.next != &head) {
+    Node* node = head.next;
+    unlink(*node);
+    link(pending, *node);
+  }
+
+  std::size_t fired = 0;
+  while (pending.next != &pending) {
+    auto* timer = static_cast<Timer*>(pending.next);
+    unlink(*timer);
+    if (timer->m_expiry > m_now) {
+      insert(*timer);
+      continue;
+    }
+
+    m_count--;
+    fired++;
+    // the callback may destroy the timer, it runs from a copy
+    Callback callback = timer->m_callback;
+    if (callback)
+      callback();
+  }
+  return fired;
+}
+
+std::size_t TimingWheel::advance(clock::time_point now) {
+  if (now < m_start)
+    return 0;
+  auto target = (std::uint64_t)(std::chrono::duration_cast<std::chrono::milliseconds>(now - m_start).count() / m_tick.count());
+
+  if (m_count == 0) {
+    if (target > m_now)
+      m_now = target;
+    return 0;
+  }
+
+  std::size_t fired = 0;
+  while (m_now < target) {
+    m_now++;
+    if ((m_now & (kSlots - 1)) == 0) {
+      // every level whose lower bits all wrapped around hands its current slot down, the highest first
+      int top = 1;
+      while (top < kLevels - 1 && ((m_now >> (kSlotBits * top)) & (kSlots - 1)) == 0)
+        top++;
+      for (int level = top; level >= 1; --level)
+        cascade(level, (int)((m_now >> (kSlotBits * level)) & (kSlots - 1)));
+    }
+    fired += expire((int)(m_now & (kSlots - 1)));
+
+    if (m_count == 0 && m_now < target)
+      m_now = target;
+  }
+  return fired;
+}
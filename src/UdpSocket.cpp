@@ -0,0 +1,248 @@
+#include <UdpSocket.h>
+
+#if !defined(WIN32) && !defined(WIN64)
+#include <net/if.h>
+#include <sys/uio.h>
+#endif
+
+using namespace thisptr::net;
+
+constexpr int UdpSocket::kMaxBatch;
+
+bool UdpEndpoint::resolve(const std::string& address, const std::string& port, UdpEndpoint& endpoint) {
+  struct addrinfo* result = thisptr::net_p::addressinfo(address.c_str(), port.c_str(), SOCK_DGRAM);
+  if (result == nullptr)
+    return false;
+
+  memcpy(&endpoint.addr, result->ai_addr, result->ai_addrlen);
+  endpoint.len = (socklen_t)result->ai_addrlen;
+  freeaddrinfo(result);
+  return true;
+}
+
+std::string UdpEndpoint::address() const {
+  char buffer[INET6_ADDRSTRLEN] = {0};
+  if (addr.ss_family == AF_INET)
+    inet_ntop(AF_INET, &((const sockaddr_in*)&addr)->sin_addr, buffer, sizeof(buffer));
+  else if (addr.ss_family == AF_INET6)
+    inet_ntop(AF_INET6, &((const sockaddr_in6*)&addr)->sin6_addr, buffer, sizeof(buffer));
+  return {buffer};
+}
+
+unsigned short UdpEndpoint::port() const {
+  if (addr.ss_family == AF_INET)
+    return ntohs(((const sockaddr_in*)&addr)->sin_port);
+  if (addr.ss_family == AF_INET6)
+    return ntohs(((const sockaddr_in6*)&addr)->sin6_port);
+  return 0;
+}
+
+UdpSocket::UdpSocket(unsigned long long sock) : m_sock(sock) {
+  thisptr::net_p::initialize();
+}
+
+UdpSocket::~UdpSocket() {
+  if (m_sock != INVALID_SOCKET)
+    thisptr::net_p::close(m_sock);
+  thisptr::net_p::cleanup();
+}
+
+bool UdpSocket::bind(const std::string& address, const std::string& port) {
+  int err = thisptr::net_p::bindDatagram(m_sock, address.c_str(), port.c_str());
+  return err == thisptr::net_p::NETE_Success && m_sock != INVALID_SOCKET;
+}
+
+bool UdpSocket::connect(const std::string& address, const std::string& port) {
+  if (m_sock != INVALID_SOCKET) {
+    // already bound, only set the default peer
+    UdpEndpoint peer;
+    if (!UdpEndpoint::resolve(address, port, peer))
+      return false;
+    return ::connect(m_sock, (const sockaddr*)&peer.addr, (int)peer.len) == 0;
+  }
+
+  int res = thisptr::net_p::connect(m_sock, address.c_str(), port.c_str(), SOCK_DGRAM);
+  return res != thisptr::net_p::NETE_SocketError;
+}
+
+int UdpSocket::recv(char* buf, int len) {
+  int iRes = thisptr::net_p::recv(m_sock, buf, len);
+  if (iRes < 0) {
+    thisptr::net_p::NetSocketError err = thisptr::net_p::lastError();
+    return err == thisptr::net_p::NETE_Wouldblock ? (int)thisptr::net_p::NETE_Success : (int)err;
+  }
+  return iRes;
+}
+
+int UdpSocket::recvFrom(char* buf, int len, UdpEndpoint& from) {
+  from.len = sizeof(from.addr);
+  int iRes = ::recvfrom(m_sock, buf, len, 0, (sockaddr*)&from.addr, &from.len);
+  if (iRes < 0) {
+    thisptr::net_p::NetSocketError err = thisptr::net_p::lastError();
+    return err == thisptr::net_p::NETE_Wouldblock ? (int)thisptr::net_p::NETE_Success : (int)err;
+  }
+  return iRes;
+}
+
+int UdpSocket::send(const char* buf) {
+  return send(buf, (int)strlen(buf));
+}
+
+int UdpSocket::send(const char* buf, int len) {
+  int iRes = thisptr::net_p::send(m_sock, buf, len);
+  return iRes < 0 ? (int)thisptr::net_p::lastError() : iRes;
+}
+
+int UdpSocket::sendTo(const char* buf, int len, const UdpEndpoint& to) {
+  int iRes = ::sendto(m_sock, buf, len, 0, (const sockaddr*)&to.addr, (int)to.len);
+  return iRes < 0 ? (int)thisptr::net_p::lastError() : iRes;
+}
+
+#ifdef __linux__
+int UdpSocket::recvBatch(Datagram* datagrams, int count) {
+  mmsghdr msgs[kMaxBatch];
+  iovec iov[kMaxBatch];
+  count = std::min(count, kMaxBatch);
+
+  for (int i = 0; i < count; ++i) {
+    iov[i].iov_base = datagrams[i].data;
+    iov[i].iov_len = datagrams[i].capacity;
+    memset(&msgs[i], 0, sizeof(mmsghdr));
+    msgs[i].msg_hdr.msg_name = &datagrams[i].peer.addr;
+    msgs[i].msg_hdr.msg_namelen = sizeof(datagrams[i].peer.addr);
+    msgs[i].msg_hdr.msg_iov = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  int n;
+  do {
+    n = ::recvmmsg((int)m_sock, msgs, (unsigned int)count, MSG_WAITFORONE, nullptr);
+  } while (n < 0 && errno == EINTR);
+
+  if (n < 0) {
+    thisptr::net_p::NetSocketError err = thisptr::net_p::lastError();
+    return err == thisptr::net_p::NETE_Wouldblock ? (int)thisptr::net_p::NETE_Success : (int)err;
+  }
+
+  for (int i = 0; i < n; ++i) {
+    datagrams[i].size = msgs[i].msg_len;
+    datagrams[i].truncated = (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+    datagrams[i].peer.len = msgs[i].msg_hdr.msg_namelen;
+  }
+  return n;
+}
+
+int UdpSocket::sendBatch(const Datagram* datagrams, int count) {
+  mmsghdr msgs[kMaxBatch];
+  iovec iov[kMaxBatch];
+
+  int sent = 0;
+  while (sent < count) {
+    int batch = std::min(count - sent, kMaxBatch);
+    for (int i = 0; i < batch; ++i) {
+      const Datagram& d = datagrams[sent + i];
+      iov[i].iov_base = d.data;
+      iov[i].iov_len = d.size;
+      memset(&msgs[i], 0, sizeof(mmsghdr));
+      if (d.peer.len > 0) {
+        msgs[i].msg_hdr.msg_name = const_cast<sockaddr_storage*>(&d.peer.addr);
+        msgs[i].msg_hdr.msg_namelen = d.peer.len;
+      }
+      msgs[i].msg_hdr.msg_iov = &iov[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    // sendmmsg may stop early, the rest goes out with the next call
+    int n = ::sendmmsg((int)m_sock, msgs, (unsigned int)batch, 0);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return sent > 0 ? sent : (int)thisptr::net_p::lastError();
+    }
+    sent += n;
+  }
+  return sent;
+}
+#else
+// no batching syscalls on this platform, fall back to one call per datagram
+int UdpSocket::recvBatch(Datagram* datagrams, int count) {
+  if (count <= 0)
+    return 0;
+
+  Datagram& d = datagrams[0];
+  int res = recvFrom(d.data, (int)d.capacity, d.peer);
+  if (res <= 0)
+    return res;
+  d.size = (std::size_t)res;
+  d.truncated = false;
+  return 1;
+}
+
+int UdpSocket::sendBatch(const Datagram* datagrams, int count) {
+  for (int i = 0; i < count; ++i) {
+    const Datagram& d = datagrams[i];
+    int res = d.peer.len > 0 ? sendTo(d.data, (int)d.size, d.peer) : send(d.data, (int)d.size);
+    if (res < 0)
+      return i > 0 ? i : res;
+  }
+  return count;
+}
+#endif
+
+bool UdpSocket::joinGroup(const std::string& group, const std::string& iface) {
+  return membership(group, iface, true);
+}
+
+bool UdpSocket::leaveGroup(const std::string& group, const std::string& iface) {
+  return membership(group, iface, false);
+}
+
+bool UdpSocket::membership(const std::string& group, const std::string& iface, bool join) {
+  ip_mreq mreq {};
+  if (inet_pton(AF_INET, group.c_str(), &mreq.imr_multiaddr) == 1) {
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (!iface.empty() && inet_pton(AF_INET, iface.c_str(), &mreq.imr_interface) != 1)
+      return false;
+    return ::setsockopt(m_sock, IPPROTO_IP, join ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP,
+                        (const char*)&mreq, sizeof(mreq)) == 0;
+  }
+
+  ipv6_mreq mreq6 {};
+  if (inet_pton(AF_INET6, group.c_str(), &mreq6.ipv6mr_multiaddr) == 1) {
+    mreq6.ipv6mr_interface = iface.empty() ? 0 : if_nametoindex(iface.c_str());
+    return ::setsockopt(m_sock, IPPROTO_IPV6, join ? IPV6_JOIN_GROUP : IPV6_LEAVE_GROUP,
+                        (const char*)&mreq6, sizeof(mreq6)) == 0;
+  }
+
+  std::cerr << "invalid multicast group: " << group << std::endl;
+  return false;
+}
+
+bool UdpSocket::setMulticastLoop(bool enabled) {
+  int value = enabled ? 1 : 0;
+  if (family() == AF_INET6)
+    return ::setsockopt(m_sock, IPPROTO_IPV6, IPV6_MULTICAST_LOOP, (const char*)&value, sizeof(value)) == 0;
+  return ::setsockopt(m_sock, IPPROTO_IP, IP_MULTICAST_LOOP, (const char*)&value, sizeof(value)) == 0;
+}
+
+bool UdpSocket::setMulticastTtl(int ttl) {
+  if (family() == AF_INET6)
+    return ::setsockopt(m_sock, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, (const char*)&ttl, sizeof(ttl)) == 0;
+  return ::setsockopt(m_sock, IPPROTO_IP, IP_MULTICAST_TTL, (const char*)&ttl, sizeof(ttl)) == 0;
+}
+
+int UdpSocket::family() const {
+  sockaddr_storage addr {};
+  socklen_t len = sizeof(addr);
+  if (getsockname(m_sock, (sockaddr*)&addr, &len) != 0)
+    return AF_UNSPEC;
+  return addr.ss_family;
+}
+
+bool UdpSocket::close() {
+  if (thisptr::net_p::close(m_sock) == 0) {
+    m_sock = INVALID_SOCKET;
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,118 @@
+#include <ZeroCopy.h>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+
+using namespace thisptr::net;
+
+void ZeroCopyTracker::hold(std::uint32_t id, std::string&& payload) {
+  m_held.push_back({id, false, std::move(payload), nullptr});
+}
+
+void ZeroCopyTracker::hold(std::uint32_t id, std::shared_ptr<const std::string> payload) {
+  m_held.push_back({id, false, std::string(), std::move(payload)});
+}
+
+int ZeroCopyTracker::reap(SOCKET sock) {
+  int released = 0;
+  std::uint32_t lo, hi;
+  bool copied;
+  int res;
+  while ((res = thisptr::net_p::readZeroCopy(sock, lo, hi, copied)) > 0) {
+    m_completed += hi - lo + 1;
+    if (copied)
+      m_copied += hi - lo + 1;
+
+    // ranges normally complete in order, but mark instead of assuming it. ids wrap around
+    for (auto& held: m_held) {
+      if (held.id - lo <= hi - lo)
+        held.done = true;
+    }
+    while (!m_held.empty() && m_held.front().done) {
+      m_held.pop_front();
+      released++;
+    }
+  }
+  return res < 0 ? res : released;
+}
+
+namespace {
+  struct Retired {
+    SOCKET sock;
+    ZeroCopyTracker tracker;
+  };
+
+  // the retired payloads and the thread that releases them while there are any. the error queue of a shut
+  // down socket cannot be waited on (it always polls as hung up), so the thread checks them periodically
+  struct Retirement {
+    ~Retirement() {
+      {
+        std::lock_guard<std::mutex> lk(mutex);
+        stopping = true;
+      }
+      cv.notify_all();
+      if (reaper.joinable())
+        reaper.join();
+      for (auto& entry: entries)
+        thisptr::net_p::close(entry.sock);
+    }
+
+    void run() {
+      std::unique_lock<std::mutex> lk(mutex);
+      while (!stopping && !entries.empty()) {
+        cv.wait_for(lk, std::chrono::milliseconds(10));
+        reap();
+      }
+      running = false;
+    }
+
+    std::size_t reap() {
+      for (auto it = entries.begin(); it != entries.end();) {
+        if (it->tracker.reap(it->sock) < 0 || it->tracker.empty()) {
+          thisptr::net_p::close(it->sock);
+          it = entries.erase(it);
+        } else
+          ++it;
+      }
+      return entries.size();
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::list<Retired> entries;
+    std::thread reaper;
+    bool running {false};
+    bool stopping {false};
+  };
+
+  Retirement retirement;
+}
+
+bool ZeroCopyTracker::retire(SOCKET sock, ZeroCopyTracker&& tracker) {
+#if defined(__linux__)
+  int copy = ::dup((int)sock);
+  if (copy < 0)
+    return false;
+  // the duplicate keeps the connection from closing, so end it for the peer here
+  ::shutdown((int)sock, SHUT_RDWR);
+  std::lock_guard<std::mutex> lk(retirement.mutex);
+  retirement.entries.push_back({(SOCKET)copy, std::move(tracker)});
+  if (!retirement.running && !retirement.stopping) {
+    // the previous reaper gave up the lock for good once it cleared running
+    if (retirement.reaper.joinable())
+      retirement.reaper.join();
+    retirement.running = true;
+    retirement.reaper = std::thread([]() { retirement.run(); });
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::size_t ZeroCopyTracker::reapRetired() {
+  std::lock_guard<std::mutex> lk(retirement.mutex);
+  return retirement.reap();
+}
@@ -1,4 +1,28 @@
 #include <net_p.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#if !defined(WIN32) && !defined(WIN64)
+#include <poll.h>
+#endif
+#ifdef __linux__
+#include <poll.h>
+#include <sys/sendfile.h>
+#include <linux/errqueue.h>
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+#endif
 
 // Error mappings from https://github.com/DFHack/clsocket/blob/master/src/SimpleSocket.cpp#L948
 #if defined(WIN32) || defined(WIN64)
@@ -18,7 +42,7 @@ std::map<int, thisptr::net_p::NetSocketError> thisptr::net_p::gSocketErrors = {
     { WSAEADDRINUSE, thisptr::net_p::NETE_AddressInUse }
 };
 #else
-    std::map<int, NetSocketError> thisptr::net_p::gSocketErrors = {
+    std::map<int, thisptr::net_p::NetSocketError> thisptr::net_p::gSocketErrors = {
         { EXIT_SUCCESS, thisptr::net_p::NETE_Success },
         { ENOTCONN, thisptr::net_p::NETE_Notconnected },
         { EINTR, thisptr::net_p::NETE_Interrupted },
@@ -32,6 +56,7 @@ std::map<int, thisptr::net_p::NetSocketError> thisptr::net_p::gSocketErrors = {
     };
 #endif
 
+#if defined(WIN32) || defined(WIN64)
 int thisptr::net_p::initialize() {
   if (gNetSockCounter == 0) {
     WSADATA wsaData;
@@ -77,14 +102,15 @@ int thisptr::net_p::close(SOCKET sock) {
   int iResult = closesocket(sock);
   return iResult;
 }
+#endif
 
-struct addrinfo *thisptr::net_p::addressinfo(const char *address, const char *port) {
+struct addrinfo *thisptr::net_p::addressinfo(const char *address, const char *port, int socktype) {
   struct addrinfo *result = nullptr, *ptr = nullptr, hints{};
 
-  ZeroMemory( &hints, sizeof(hints) );
+  memset( &hints, 0, sizeof(hints) );
   hints.ai_family = AF_UNSPEC;
-  hints.ai_socktype = SOCK_STREAM;
-  hints.ai_protocol = IPPROTO_TCP;
+  hints.ai_socktype = socktype;
+  hints.ai_protocol = socktype == SOCK_DGRAM ? IPPROTO_UDP : IPPROTO_TCP;
 
   // Resolve the server address and port
   int iResult = getaddrinfo(address, port, &hints, &result);
@@ -95,9 +121,9 @@ struct addrinfo *thisptr::net_p::addressinfo(const char *address, const char *po
   return result;
 }
 
-int thisptr::net_p::connect(SOCKET &sock, const char *address, const char *port) {
+int thisptr::net_p::connect(SOCKET &sock, const char *address, const char *port, int socktype) {
   struct addrinfo *result = nullptr, *ptr = nullptr;
-  result = addressinfo(address, port);
+  result = addressinfo(address, port, socktype);
   if ( result == nullptr ) {
     return NETE_SocketError;
   }
@@ -130,11 +156,147 @@ int thisptr::net_p::connect(SOCKET &sock, const char *address, const char *port)
   return 0;
 }
 
+namespace {
+  bool connectPending() {
+#if defined(WIN32) || defined(WIN64)
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EINPROGRESS;
+#endif
+  }
+
+  int pollSockets(std::vector<pollfd>& fds, int timeoutMs) {
+#if defined(WIN32) || defined(WIN64)
+    return WSAPoll(fds.data(), (ULONG)fds.size(), timeoutMs);
+#else
+    return poll(fds.data(), (nfds_t)fds.size(), timeoutMs);
+#endif
+  }
+
+  long millisecondsUntil(std::chrono::steady_clock::time_point when) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(when - std::chrono::steady_clock::now());
+    return std::max<long>(0, (long)left.count());
+  }
+}
+
+int thisptr::net_p::connectTimeout(SOCKET &sock, const char *address, const char *port, long timeoutMs,
+                                   long attemptDelayMs) {
+  sock = INVALID_SOCKET;
+  struct addrinfo *result = addressinfo(address, port);
+  if ( result == nullptr ) {
+    return NETE_SocketError;
+  }
+
+  int iResult = connectTimeout(sock, result, timeoutMs, attemptDelayMs);
+  freeaddrinfo(result);
+  return iResult;
+}
+
+int thisptr::net_p::connectTimeout(SOCKET &sock, const struct addrinfo *addresses, long timeoutMs,
+                                   long attemptDelayMs) {
+  sock = INVALID_SOCKET;
+  if (addresses == nullptr)
+    return NETE_SocketError;
+
+  // alternate the address families, starting with the one the resolver preferred
+  std::vector<const struct addrinfo*> preferred, other, order;
+  for (const struct addrinfo* ptr = addresses; ptr != nullptr; ptr = ptr->ai_next)
+    (ptr->ai_family == addresses->ai_family ? preferred : other).push_back(ptr);
+  for (std::size_t i = 0; i < preferred.size() || i < other.size(); ++i) {
+    if (i < preferred.size())
+      order.push_back(preferred[i]);
+    if (i < other.size())
+      order.push_back(other[i]);
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  auto nextAttempt = std::chrono::steady_clock::now();
+  std::vector<SOCKET> attempts;
+  std::vector<pollfd> fds;
+  std::size_t next = 0;
+  bool bTimedOut = false;
+
+  while (sock == INVALID_SOCKET) {
+    if (next < order.size() && (attempts.empty() || millisecondsUntil(nextAttempt) == 0)) {
+      const struct addrinfo* ptr = order[next++];
+      SOCKET attempt = socket(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol);
+      if (attempt == INVALID_SOCKET)
+        continue;
+      setBlocking(attempt, false);
+      if (::connect(attempt, ptr->ai_addr, (int)ptr->ai_addrlen) == 0) {
+        sock = attempt;
+        break;
+      }
+      if (!connectPending()) {
+        close(attempt);
+        continue;
+      }
+      attempts.push_back(attempt);
+      nextAttempt = std::chrono::steady_clock::now() + std::chrono::milliseconds(attemptDelayMs);
+    }
+
+    if (attempts.empty())
+      break; // every address failed
+    if (timeoutMs > 0 && millisecondsUntil(deadline) == 0) {
+      bTimedOut = true;
+      break;
+    }
+
+    // sleep until one of them completes, the next attempt is due or the deadline passed
+    long wait = next < order.size() ? millisecondsUntil(nextAttempt) : -1;
+    if (timeoutMs > 0)
+      wait = wait < 0 ? millisecondsUntil(deadline) : std::min(wait, millisecondsUntil(deadline));
+    fds.resize(attempts.size());
+    for (std::size_t i = 0; i < attempts.size(); ++i) {
+      fds[i].fd = attempts[i];
+      fds[i].events = POLLOUT;
+      fds[i].revents = 0;
+    }
+    if (pollSockets(fds, (int)wait) < 0) {
+      if (lastError() == NETE_Interrupted)
+        continue;
+      break;
+    }
+
+    for (std::size_t i = attempts.size(); i-- > 0;) {
+      if (fds[i].revents == 0)
+        continue;
+      int err = 0;
+      socklen_t len = sizeof(err);
+      getsockopt(attempts[i], SOL_SOCKET, SO_ERROR, (char*)&err, &len);
+      if (err == 0 && sock == INVALID_SOCKET)
+        sock = attempts[i];
+      else
+        close(attempts[i]);
+      attempts.erase(attempts.begin() + i);
+    }
+  }
+
+  for (SOCKET attempt: attempts)
+    close(attempt);
+
+  if (sock == INVALID_SOCKET)
+    return bTimedOut ? NETE_Timedout : NETE_SocketError;
+  setBlocking(sock, true);
+  return NETE_Success;
+}
+
 int thisptr::net_p::setsockopt(SOCKET sock, int opt, const void *val, int size) {
   const char* s = (const char *)val;
   return ::setsockopt(sock, SOL_SOCKET, opt, s, size);
 }
 
+int thisptr::net_p::setTimeout(SOCKET sock, int opt, long milliseconds) {
+#if defined(WIN32) || defined(WIN64)
+  DWORD timeout = (DWORD)milliseconds;
+#else
+  struct timeval timeout;
+  timeout.tv_sec = milliseconds / 1000;
+  timeout.tv_usec = (milliseconds % 1000) * 1000;
+#endif
+  return setsockopt(sock, opt, &timeout, sizeof(timeout));
+}
+
 int thisptr::net_p::send(SOCKET sock, const char *buffer, int len) {
   int iResult = ::send( sock, buffer, len, 0 );
   return iResult;
@@ -145,11 +307,161 @@ int thisptr::net_p::recv(SOCKET sock, char *buffer, int len) {
   return iResult;
 }
 
+int thisptr::net_p::peek(SOCKET sock, bool wait) {
+  // blocks until at least one byte can be read, without taking it off the socket
+  char c;
+#if defined(WIN32) || defined(WIN64)
+  if (!wait) setBlocking(sock, false);
+  int iResult = ::recv(sock, &c, 1, MSG_PEEK);
+  if (!wait) setBlocking(sock, true);
+#else
+  int iResult = ::recv(sock, &c, 1, wait ? MSG_PEEK : MSG_PEEK | MSG_DONTWAIT);
+#endif
+  return iResult;
+}
+
+long long thisptr::net_p::sendFile(SOCKET sock, int fd, long long offset, std::size_t len) {
+#if defined(__linux__)
+  off_t off = (off_t)offset;
+  ssize_t iResult = ::sendfile((int)sock, fd, &off, len);
+  if (iResult >= 0 || (errno != EINVAL && errno != ENOSYS && errno != ESPIPE))
+    return iResult;
+
+  // sendfile does not take this kind of file (e.g. a pipe or some proc/fuse files), route it through a
+  // kernel pipe instead. a pipe holds at most 64k. when the socket is full a seekable source stops with the
+  // partial count, the caller resumes at offset + sent. what an unseekable source put in the pipe cannot be
+  // read again, so that is drained first, waiting at most the socket's send timeout
+  timeval sndTimeout {0, 0};
+  socklen_t optLen = sizeof(sndTimeout);
+  ::getsockopt((int)sock, SOL_SOCKET, SO_SNDTIMEO, &sndTimeout, &optLen);
+  int waitMs = (int)(sndTimeout.tv_sec * 1000 + sndTimeout.tv_usec / 1000);
+  if (waitMs <= 0)
+    waitMs = -1;
+
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) < 0)
+    return NETE_SocketError;
+
+  loff_t in = (loff_t)offset;
+  loff_t* inOffset = lseek(fd, 0, SEEK_CUR) < 0 && errno == ESPIPE ? nullptr : &in;
+  long long sent = 0;
+  bool failed = false;
+  bool full = false;
+  while (!failed && !full && (std::size_t)sent < len) {
+    ssize_t n = splice(fd, inOffset, fds[1], nullptr, len - (std::size_t)sent, SPLICE_F_MOVE | SPLICE_F_MORE);
+    if (n <= 0) {
+      failed = n < 0 && errno != EINTR;
+      if (n == 0 || failed)
+        break;
+      continue;
+    }
+    while (n > 0) {
+      ssize_t out = splice(fds[0], nullptr, (int)sock, nullptr, (std::size_t)n, SPLICE_F_MOVE | SPLICE_F_MORE);
+      if (out > 0) {
+        sent += out;
+        n -= out;
+      } else if (out < 0 && errno == EINTR) {
+        continue;
+      } else if (out < 0 && errno == EAGAIN && inOffset) {
+        full = true;
+        break;
+      } else if (out < 0 && errno == EAGAIN) {
+        pollfd pfd {(int)sock, POLLOUT, 0};
+        if (poll(&pfd, 1, waitMs) == 0) {
+          errno = ETIMEDOUT;
+          failed = true;
+          break;
+        }
+      } else {
+        failed = true;
+        break;
+      }
+    }
+  }
+  int err = errno;
+  ::close(fds[0]);
+  ::close(fds[1]);
+  errno = err;
+  // nothing went out on a full socket: EAGAIN like sendfile itself, zero would read as the end of the file
+  return sent > 0 || (!failed && !full) ? sent : (long long)NETE_SocketError;
+#elif defined(WIN32) || defined(WIN64)
+  WSASetLastError(WSAEOPNOTSUPP);
+  return NETE_SocketError;
+#else
+  // no zero-copy primitive, fall back to a bounded copy
+  char buffer[64 * 1024];
+  ssize_t n = pread(fd, buffer, len < sizeof(buffer) ? len : sizeof(buffer), (off_t)offset);
+  if (n <= 0)
+    return n;
+  return ::send(sock, buffer, (std::size_t)n, 0);
+#endif
+}
+
+int thisptr::net_p::enableZeroCopy(SOCKET sock) {
+#if defined(__linux__)
+  int one = 1;
+  return setsockopt(sock, SO_ZEROCOPY, &one, sizeof(one));
+#else
+  return NETE_SocketError;
+#endif
+}
+
+int thisptr::net_p::sendZeroCopy(SOCKET sock, const char *buffer, int len) {
+#if defined(__linux__)
+  return (int)::send((int)sock, buffer, (std::size_t)len, MSG_ZEROCOPY | MSG_NOSIGNAL);
+#else
+  return NETE_SocketError;
+#endif
+}
+
+int thisptr::net_p::readZeroCopy(SOCKET sock, uint32_t &lo, uint32_t &hi, bool &copied) {
+#if defined(__linux__)
+  char control[128];
+  while (true) {
+    msghdr msg{};
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (::recvmsg((int)sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+      if (errno == EINTR)
+        continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : NETE_SocketError;
+    }
+
+    // anything else on the queue, e.g. an icmp error, is skipped
+    for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+      if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+            (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)))
+        continue;
+      auto* err = (sock_extended_err*)CMSG_DATA(cm);
+      if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+        continue;
+      lo = err->ee_info;
+      hi = err->ee_data;
+      copied = (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+      return 1;
+    }
+  }
+#else
+  return 0;
+#endif
+}
+
+int thisptr::net_p::waitZeroCopy(SOCKET sock, int timeoutMs) {
+#if defined(__linux__)
+  // the error queue is not a readable event, a non-empty one shows up as POLLERR
+  pollfd pfd {(int)sock, 0, 0};
+  int iResult = poll(&pfd, 1, timeoutMs);
+  return iResult > 0 && (pfd.revents & POLLERR) ? 1 : iResult < 0 ? NETE_SocketError : 0;
+#else
+  return 0;
+#endif
+}
+
 int thisptr::net_p::shutdown(SOCKET sock, char c) {
   int iResult = ::shutdown(sock, c);
   if (iResult == NETE_SocketError) {
-    closesocket(sock);
-    WSACleanup();
+    close(sock);
+    cleanup();
     return -1;
   }
   return iResult;
@@ -187,6 +499,37 @@ int thisptr::net_p::listen(SOCKET &sock, const char *address, const char *port)
   return 0;
 }
 
+int thisptr::net_p::bindDatagram(SOCKET &sock, const char *address, const char *port) {
+  struct addrinfo *result = nullptr;
+  result = addressinfo(address, port, SOCK_DGRAM);
+  if ( result == nullptr ) {
+    return lastError();
+  }
+
+  sock = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+  if (sock == INVALID_SOCKET) {
+    freeaddrinfo(result);
+    return lastError();
+  }
+
+  // several receivers may bind the same multicast group and port
+  int reuse = 1;
+  setsockopt(sock, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  int iResult = ::bind( sock, result->ai_addr, (int)result->ai_addrlen);
+  if (iResult == NETE_SocketError) {
+    NetSocketError err = lastError();
+    freeaddrinfo(result);
+    close(sock);
+    sock = INVALID_SOCKET;
+    return err;
+  }
+
+  freeaddrinfo(result);
+
+  return 0;
+}
+
 SOCKET thisptr::net_p::accept(SOCKET sock) {
   // Accept a client socket
   SOCKET cliSocket = ::accept(sock, nullptr, nullptr);
@@ -0,0 +1,87 @@
+#ifndef WITH_ASIO
+#warning "To run this sample, you should enable asio in the cmakelists options."
+int main() { return 0; }
+#else
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <Net.h>
+
+using namespace thisptr::net;
+using namespace std::chrono_literals;
+
+const std::size_t kPayloadSize = 8 * 1024 * 1024;
+
+class ClientHandler: public AsyncConnectionHandlerBase<AsioTcpSocket<ClientHandler>> {
+public:
+  bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {
+    return !ec;
+  }
+
+  bool onBufferReceived(asio::ip::tcp::socket& sock, std::error_code ec, asio::const_buffer payload) override {
+    if (ec == std::errc::timed_out)
+      m_readTimedOut = true;
+    return false;
+  }
+
+  void onDataSent(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {
+    m_writeFailed = (bool)ec;
+    m_written = true;
+  }
+
+  std::atomic<bool> m_readTimedOut {false};
+  std::atomic<bool> m_writeFailed {false};
+  std::atomic<bool> m_written {false};
+};
+
+int main() {
+  SOCKET listener;
+  if (thisptr::net_p::listen(listener, "127.0.0.1", "7253") != thisptr::net_p::NETE_Success) {
+    std::cout << "unable to bind to host" << std::endl;
+    return 1;
+  }
+
+  // the peer never answers and only starts reading once the client's read deadline has passed
+  std::atomic<std::size_t> received {0};
+  std::thread peer([listener, &received]() {
+    BlockingTcpSocket conn(thisptr::net_p::accept(listener));
+    conn.setReadTimeout(2000ms);
+    std::this_thread::sleep_for(500ms);
+    char buffer[64 * 1024];
+    while (received < kPayloadSize) {
+      int res = conn.recv(buffer, sizeof(buffer));
+      if (res <= 0)
+        break;
+      received += res;
+    }
+  });
+
+  auto handler = std::make_shared<ClientHandler>();
+  {
+    AsyncTcpClient<ClientHandler> c(handler);
+    c.setReadTimeout(150ms);
+    c.setWriteTimeout(5000ms);
+    if (!c.connect("127.0.0.1", "7253")) {
+      std::cout << "unable to connect to host" << std::endl;
+      return 1;
+    }
+    c.recv();
+    std::string payload(kPayloadSize, 'x');
+    c.send(payload.data(), (int)payload.size());
+
+    for (int i = 0; i < 500 && !handler->m_written; ++i)
+      std::this_thread::sleep_for(10ms);
+    std::cout << "read: " << (handler->m_readTimedOut ? "timed out" : "no timeout") << std::endl;
+    std::cout << "write in flight meanwhile: " << (handler->m_written && !handler->m_writeFailed ? "completed" : "aborted")
+              << std::endl;
+    peer.join();
+    std::cout << "peer received " << received << " of " << kPayloadSize << " bytes" << std::endl;
+    c.close();
+  }
+
+  thisptr::net_p::close(listener);
+  return handler->m_readTimedOut && !handler->m_writeFailed && received == kPayloadSize ? 0 : 1;
+}
+
+#endif
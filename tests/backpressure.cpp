@@ -0,0 +1,96 @@
+#ifndef WITH_ASIO
+#warning "To run this sample, you should enable asio in the cmakelists options."
+int main() { return 0; }
+#else
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <Net.h>
+
+using namespace thisptr::net;
+using namespace std::chrono_literals;
+
+const std::size_t kChunk = 16 * 1024;
+const std::size_t kTotal = 8 * 1024 * 1024;
+const std::size_t kLowWatermark = 64 * 1024;
+const std::size_t kHighWatermark = 256 * 1024;
+
+// streams kTotal bytes to a peer that is slow to read, pausing whenever the socket reports backpressure
+class ProducerHandler: public AsyncConnectionHandlerBase<AsioTcpSocket<ProducerHandler>> {
+public:
+  bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {
+    return !ec;
+  }
+
+  void onDataSent(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {}
+
+  void onWriteBlocked(asio::ip::tcp::socket& sock, std::size_t pending) override {
+    m_blocked++;
+  }
+
+  void onWritable(asio::ip::tcp::socket& sock) override {
+    m_writable++;
+    produce();
+  }
+
+  void produce() {
+    while (m_produced < kTotal) {
+      m_produced += kChunk;
+      if (m_conn->send(std::string(kChunk, 'x')) == AsioTcpSocket<ProducerHandler>::kOverWatermark)
+        break;
+    }
+    m_maxPending = std::max(m_maxPending, m_conn->pendingBytes());
+  }
+
+  std::shared_ptr<AsioTcpSocket<ProducerHandler>> m_conn;
+  std::size_t m_produced {0};
+  std::size_t m_maxPending {0};
+  int m_blocked {0};
+  int m_writable {0};
+};
+
+int main() {
+  SOCKET listener;
+  if (thisptr::net_p::listen(listener, "127.0.0.1", "7241") != thisptr::net_p::NETE_Success) {
+    std::cout << "unable to bind to host" << std::endl;
+    return 1;
+  }
+
+  std::atomic<std::size_t> consumed {0};
+  std::thread consumer([&]() {
+    SOCKET sock = thisptr::net_p::accept(listener);
+    BlockingTcpSocket conn(sock);
+    // let the producer run into the watermark first
+    std::this_thread::sleep_for(200ms);
+    char buffer[64 * 1024];
+    while (consumed < kTotal) {
+      int res = conn.recv(buffer, sizeof(buffer));
+      if (res <= 0)
+        break;
+      consumed += res;
+    }
+  });
+
+  asio::io_context context;
+  auto handler = std::make_shared<ProducerHandler>();
+  handler->m_conn = std::make_shared<AsioTcpSocket<ProducerHandler>>(context, handler);
+  if (!handler->m_conn->connect("127.0.0.1", "7241")) {
+    std::cout << "unable to connect to host" << std::endl;
+    return 1;
+  }
+  handler->m_conn->setWriteWatermarks(kLowWatermark, kHighWatermark);
+  handler->produce();
+
+  context.run_for(10s);
+  consumer.join();
+  handler->m_conn->close();
+  thisptr::net_p::close(listener);
+
+  std::cout << "bytes consumed: " << consumed << " of " << kTotal << std::endl;
+  std::cout << "blocked " << handler->m_blocked << " times, resumed " << handler->m_writable << " times" << std::endl;
+  std::cout << "largest backlog: " << handler->m_maxPending << " bytes" << std::endl;
+  return 0;
+}
+
+#endif
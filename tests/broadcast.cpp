@@ -0,0 +1,97 @@
+#ifndef WITH_ASIO
+#warning "To run this sample, you should enable asio in the cmakelists options."
+int main() { return 0; }
+#else
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <Net.h>
+
+using namespace thisptr::net;
+using namespace std::chrono_literals;
+
+const int kClients = 8;
+const int kMessages = 16;
+const std::size_t kMessageSize = 64 * 1024;
+
+class FanOutHandler: public AsyncConnectionHandlerBase<AsioTcpSocket<FanOutHandler>> {
+public:
+  bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {
+    return !ec;
+  }
+
+  void onDataSent(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {}
+
+  void onNewConnection(asio::ip::tcp::socket& sock) override;
+};
+
+auto handler = std::make_shared<FanOutHandler>();
+AsyncTcpServer<FanOutHandler> s(handler);
+
+void FanOutHandler::onNewConnection(asio::ip::tcp::socket& sock) {
+  s.connection(s.adopt(sock))->recv();
+}
+
+int main() {
+  s.start("127.0.0.1", "7246");
+
+  std::vector<std::unique_ptr<TcpClient<BlockingTcpSocket>>> clients;
+  for (int i = 0; i < kClients; ++i) {
+    clients.emplace_back(new TcpClient<BlockingTcpSocket>());
+    if (!clients.back()->connect("127.0.0.1", "7246")) {
+      std::cout << "unable to connect to host" << std::endl;
+      return 1;
+    }
+  }
+  for (int i = 0; i < 100 && s.connections() != kClients; ++i)
+    std::this_thread::sleep_for(10ms);
+
+  std::string message(kMessageSize, '\0');
+  for (std::size_t i = 0; i < message.size(); ++i)
+    message[i] = (char)('a' + i % 26);
+  SharedBuffer payload = makeSharedBuffer(message);
+
+  std::atomic<int> intact {0};
+  std::vector<std::thread> readers;
+  for (auto& c: clients) {
+    TcpClient<BlockingTcpSocket>* client = c.get();
+    readers.emplace_back([client, &message, &intact]() {
+      std::string received;
+      std::vector<char> buffer(kMessageSize);
+      while (received.size() < kMessages * kMessageSize) {
+        int res = client->recv(buffer.data(), (int)buffer.size());
+        if (res <= 0)
+          break;
+        received.append(buffer.data(), res);
+      }
+      bool ok = received.size() == kMessages * kMessageSize;
+      for (int i = 0; ok && i < kMessages; ++i)
+        ok = received.compare(i * kMessageSize, kMessageSize, message) == 0;
+      if (ok)
+        intact++;
+    });
+  }
+
+  std::size_t queued = 0;
+  for (int i = 0; i < kMessages; ++i)
+    queued += s.broadcast(payload);
+  std::cout << "queued " << queued << " sends of one " << payload->size() << " byte buffer" << std::endl;
+
+  for (auto& t: readers)
+    t.join();
+  std::cout << "clients received intact: " << intact << " of " << kClients << std::endl;
+
+  // every socket dropped its reference once written
+  for (int i = 0; i < 100 && payload.use_count() > 1; ++i)
+    std::this_thread::sleep_for(10ms);
+  std::cout << "buffer released by all sockets: " << (payload.use_count() == 1 ? "yes" : "no") << std::endl;
+
+  for (auto& c: clients)
+    c->close();
+  s.stop();
+  return 0;
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef WITH_ASIO
+#warning "To run this sample, you should enable asio in the cmakelists options."
+int main() { return 0; }
+#else
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <Net.h>
+
+using namespace thisptr::net;
+using namespace std::chrono_literals;
+
+const int kConnections = 16;
+
+BufferPool pool(4096, 64);
+std::atomic<int> received {0};
+std::atomic<std::size_t> lentWhileReading {0};
+
+class ReadingHandler: public AsyncConnectionHandlerBase<AsioTcpSocket<ReadingHandler>> {
+public:
+  bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {
+    if (ec)
+      return false;
+    // the slab holding payload is still lent out at this point
+    std::size_t lent = pool.outstanding();
+    std::size_t seen = lentWhileReading;
+    while (lent > seen && !lentWhileReading.compare_exchange_weak(seen, lent)) {}
+    received++;
+    return true;
+  }
+
+  void onDataSent(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {}
+};
+
+int main() {
+  SOCKET listener;
+  if (thisptr::net_p::listen(listener, "127.0.0.1", "7256") != thisptr::net_p::NETE_Success) {
+    std::cout << "unable to bind to host" << std::endl;
+    return 1;
+  }
+
+  asio::io_context context;
+  auto work = asio::make_work_guard(context);
+  std::thread io([&]() { context.run(); });
+
+  std::vector<std::shared_ptr<ReadingHandler>> handlers;
+  std::vector<std::shared_ptr<AsioTcpSocket<ReadingHandler>>> socks;
+  std::vector<SOCKET> peers;
+  for (int i = 0; i < kConnections; ++i) {
+    handlers.push_back(std::make_shared<ReadingHandler>());
+    socks.push_back(std::make_shared<AsioTcpSocket<ReadingHandler>>(context, handlers.back()));
+    socks.back()->setBufferPool(&pool);
+    if (!socks.back()->connect("127.0.0.1", "7256")) {
+      std::cout << "unable to connect to host" << std::endl;
+      context.stop();
+      io.join();
+      return 1;
+    }
+    peers.push_back(thisptr::net_p::accept(listener));
+    socks.back()->recv();
+  }
+
+  // every connection is waiting for data, none of them should hold a slab
+  std::this_thread::sleep_for(100ms);
+  std::size_t idle = pool.outstanding();
+  std::cout << kConnections << " idle connections hold " << idle << " slabs" << std::endl;
+
+  for (auto peer: peers)
+    thisptr::net_p::send(peer, "hello", 5);
+  for (int i = 0; i < 200 && received < kConnections; ++i)
+    std::this_thread::sleep_for(10ms);
+  // the reads completed and the connections went back to waiting
+  std::this_thread::sleep_for(50ms);
+  std::size_t after = pool.outstanding();
+  std::cout << "received on " << received << " connections, up to " << lentWhileReading
+            << " slabs lent while reading, " << after << " held afterwards" << std::endl;
+
+  for (auto& sock: socks)
+    sock->close();
+  work.reset();
+  io.join();
+  socks.clear();
+  for (auto peer: peers)
+    thisptr::net_p::close(peer);
+  thisptr::net_p::close(listener);
+
+  return idle == 0 && received == kConnections && lentWhileReading > 0 && after == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,133 @@
+#if !defined(__linux__) || !defined(WITH_ASIO)
+#warning "This sample needs asio and a linux listen backlog, enable asio in the cmakelists options."
+int main() { return 0; }
+#else
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <Net.h>
+
+using namespace thisptr::net;
+using namespace std::chrono_literals;
+
+class ClientHandler: public AsyncConnectionHandlerBase<AsioTcpSocket<ClientHandler>> {
+public:
+  void onConnected(asio::ip::tcp::socket& sock, const std::string& endpoint) override {
+    m_connected = true;
+  }
+
+  bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {
+    if (ec)
+      m_failed = true;
+    else
+      m_received += payload;
+    return !ec;
+  }
+
+  void onDataSent(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {}
+
+  std::atomic<bool> m_connected {false};
+  std::atomic<bool> m_failed {false};
+  std::string m_received;
+};
+
+long long elapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+  // a listener whose backlog is full drops further handshakes, like an unreachable host
+  int blackhole = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(7247);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(blackhole, (sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(blackhole, 0) != 0) {
+    std::cout << "unable to bind to host" << std::endl;
+    return 1;
+  }
+  TcpClient<BlockingTcpSocket> filler;
+  filler.connect("127.0.0.1", "7247");
+
+  TcpClient<BlockingTcpSocket> blocking;
+  blocking.setConnectTimeout(200ms);
+  auto start = std::chrono::steady_clock::now();
+  bool connected = blocking.connect("127.0.0.1", "7247");
+  long long took = elapsedMs(start);
+  std::cout << "blocking connect to unresponsive host: "
+            << (!connected && took < 1000 ? "gave up in time" : "hung") << std::endl;
+
+  auto handler = std::make_shared<ClientHandler>();
+  {
+    AsyncTcpClient<ClientHandler> async(handler);
+    async.setConnectTimeout(200ms);
+    start = std::chrono::steady_clock::now();
+    async.connect("127.0.0.1", "7247");
+    async.recv();
+    while (!handler->m_failed && elapsedMs(start) < 2000)
+      std::this_thread::sleep_for(10ms);
+    std::cout << "async connect to unresponsive host: "
+              << (handler->m_failed && !handler->m_connected && elapsedMs(start) < 1000 ? "gave up in time" : "hung")
+              << std::endl;
+  }
+
+  // running out of time says nothing about the addresses, the cache keeps them
+  ResolverCache cache;
+  {
+    TcpClient<BlockingTcpSocket> blockingCached;
+    blockingCached.setResolverCache(&cache);
+    blockingCached.setConnectTimeout(200ms);
+    bool kept = !blockingCached.connect("127.0.0.1", "7247") && cache.find("127.0.0.1", "7247");
+
+    handler = std::make_shared<ClientHandler>();
+    {
+      AsyncTcpClient<ClientHandler> async(handler);
+      async.setResolverCache(&cache);
+      async.setConnectTimeout(200ms);
+      async.connect("127.0.0.1", "7247");
+      async.recv();
+      start = std::chrono::steady_clock::now();
+      while (!handler->m_failed && elapsedMs(start) < 2000)
+        std::this_thread::sleep_for(10ms);
+    }
+    kept = kept && handler->m_failed && cache.find("127.0.0.1", "7247");
+    std::cout << "cached addresses after timed out connects: " << (kept ? "kept" : "dropped") << std::endl;
+  }
+
+  SOCKET listener;
+  if (thisptr::net_p::listen(listener, "127.0.0.1", "7248") != thisptr::net_p::NETE_Success) {
+    std::cout << "unable to bind to host" << std::endl;
+    return 1;
+  }
+  std::thread echo([listener]() {
+    BlockingTcpSocket conn(thisptr::net_p::accept(listener));
+    char buffer[64];
+    int res = conn.recv(buffer, sizeof(buffer));
+    if (res > 0)
+      conn.send(buffer, res);
+    conn.recv(buffer, sizeof(buffer));
+  });
+
+  // what is sent before the connect completed waits for it
+  handler = std::make_shared<ClientHandler>();
+  {
+    AsyncTcpClient<ClientHandler> async(handler);
+    async.setConnectTimeout(1000ms);
+    async.connect("127.0.0.1", "7248");
+    async.send("early");
+    async.recv();
+    for (int i = 0; i < 200 && handler->m_received.size() < 5 && !handler->m_failed; ++i)
+      std::this_thread::sleep_for(10ms);
+    std::cout << "async send issued before connected: "
+              << (handler->m_connected && handler->m_received == "early" ? "echoed" : "lost") << std::endl;
+    async.close();
+  }
+
+  echo.join();
+  thisptr::net_p::close(listener);
+  ::close(blackhole);
+  return 0;
+}
+
+#endif
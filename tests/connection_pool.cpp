@@ -0,0 +1,81 @@
+#ifndef __linux__
+#warning "This sample needs epoll, it only runs on linux."
+int main() { return 0; }
+#else
+
+#include <iostream>
+
+#include <atomic>
+#include <thread>
+#include <EpollServer.h>
+#include <ConnectionPool.h>
+
+using namespace thisptr::net;
+
+std::atomic<int> connections {0};
+
+class EchoConnectionHandler: public BlockingTcpHandler {
+public:
+  void onConnect() override {
+    ++connections;
+  }
+
+  void onMessage(std::string data) override {
+    // lets the client check that dropped connections are not handed out again
+    if (data == "bye") {
+      m_conn->close();
+      return;
+    }
+    m_conn->send(data.c_str(), (int)data.length());
+  }
+};
+
+EpollTcpServer<EchoConnectionHandler> s;
+
+bool roundTrip(BlockingConnectionPool& pool, const std::string& payload) {
+  BlockingConnectionPool::Lease conn = pool.borrow("127.0.0.1", "7238");
+  if (!conn) {
+    std::cout << "unable to borrow a connection" << std::endl;
+    return false;
+  }
+
+  char buffer[256] = {0};
+  if (conn->send(payload.c_str(), (int)payload.length()) <= 0 || conn->recv(buffer, 256) <= 0) {
+    conn.invalidate();
+    return false;
+  }
+  return std::string(buffer) == payload;
+}
+
+int main() {
+  using namespace std::chrono_literals;
+
+  s.setWorkers(1);
+  s.setNewHandler([]() -> std::shared_ptr<EchoConnectionHandler> {
+    return std::make_shared<EchoConnectionHandler>();
+  });
+  s.start("127.0.0.1", "7238");
+
+  BlockingConnectionPool pool;
+  bool bRes = true;
+  for (int i = 0; i < 20; ++i)
+    bRes = roundTrip(pool, "ping " + std::to_string(i)) && bRes;
+  std::cout << "connections after 20 requests: " << connections << std::endl;
+  bRes = bRes && connections == 1;
+
+  // the server drops the idle connection, the next borrow has to notice and reconnect
+  {
+    BlockingConnectionPool::Lease conn = pool.borrow("127.0.0.1", "7238");
+    conn->send("bye");
+  }
+  std::this_thread::sleep_for(200ms);
+  bRes = roundTrip(pool, "pong") && bRes;
+  std::cout << "connections after reconnect: " << connections << std::endl;
+  bRes = bRes && connections == 2;
+
+  s.stop();
+  s.waitForFinished();
+  return bRes ? 0 : 1;
+}
+
+#endif
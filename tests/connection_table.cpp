@@ -0,0 +1,124 @@
+#ifndef WITH_ASIO
+#warning "To run this sample, you should enable asio in the cmakelists options."
+int main() { return 0; }
+#else
+
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <Net.h>
+
+using namespace thisptr::net;
+using namespace std::chrono_literals;
+
+const int kChurn = 64;
+
+class EchoHandler: public std::enable_shared_from_this<EchoHandler>,
+    public AsyncConnectionHandlerBase<AsioTcpSocket<EchoHandler>> {
+public:
+  bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {
+    return !ec;
+  }
+
+  void onDataSent(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {}
+
+  void onNewConnection(asio::ip::tcp::socket& sock) override;
+
+  std::mutex m_mutex;
+  std::vector<ConnectionId> m_ids;
+};
+
+auto handler = std::make_shared<EchoHandler>();
+AsyncTcpServer<EchoHandler> s(handler);
+
+void EchoHandler::onNewConnection(asio::ip::tcp::socket& sock) {
+  ConnectionId id = s.adopt(sock);
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_ids.push_back(id);
+  }
+  s.connection(id)->recv();
+}
+
+// polls the server until it holds the expected number of connections
+bool waitForConnections(std::size_t expected) {
+  for (int i = 0; i < 100 && s.connections() != expected; ++i)
+    std::this_thread::sleep_for(10ms);
+  return s.connections() == expected;
+}
+
+int main() {
+  // one context run by several threads, so the completions of one connection may run on different threads
+  s.setWorkers(4);
+  s.start("127.0.0.1", "7245");
+
+  std::vector<std::unique_ptr<TcpClient<BlockingTcpSocket>>> clients;
+  for (int i = 0; i < 4; ++i) {
+    clients.emplace_back(new TcpClient<BlockingTcpSocket>());
+    if (!clients.back()->connect("127.0.0.1", "7245")) {
+      std::cout << "unable to connect to host" << std::endl;
+      return 1;
+    }
+  }
+  std::cout << "adopted: " << (waitForConnections(4) ? "4" : "missing") << std::endl;
+
+  // closing by id from outside the io threads
+  ConnectionId first;
+  {
+    std::lock_guard<std::mutex> lk(handler->m_mutex);
+    first = handler->m_ids.front();
+  }
+  s.close(first);
+  bool released = waitForConnections(3) && !s.connection(first);
+  std::cout << "closed by id: " << (released ? "released" : "still there") << std::endl;
+  std::cout << "closed id refused: " << (!s.close(first) ? "yes" : "no") << std::endl;
+
+  // the freed slot comes back with a new generation
+  clients.emplace_back(new TcpClient<BlockingTcpSocket>());
+  clients.back()->connect("127.0.0.1", "7245");
+  waitForConnections(4);
+  ConnectionId reused;
+  {
+    std::lock_guard<std::mutex> lk(handler->m_mutex);
+    reused = handler->m_ids.back();
+  }
+  std::cout << "slot reused with new id: "
+            << (((reused & 0xffffffffu) == (first & 0xffffffffu) && reused != first) ? "yes" : "no") << std::endl;
+
+  // clients going away free their connections on their own
+  for (auto& c: clients)
+    c->close();
+  std::cout << "disconnected clients released: " << (waitForConnections(0) ? "all" : "not all") << std::endl;
+
+  // closed by the server and the client at once, while reads are in flight on the io threads
+  clients.clear();
+  {
+    std::lock_guard<std::mutex> lk(handler->m_mutex);
+    handler->m_ids.clear();
+  }
+  for (int i = 0; i < kChurn; ++i) {
+    clients.emplace_back(new TcpClient<BlockingTcpSocket>());
+    clients.back()->connect("127.0.0.1", "7245");
+    clients.back()->send("ping", 4);
+  }
+  waitForConnections(kChurn);
+  std::vector<ConnectionId> ids;
+  {
+    std::lock_guard<std::mutex> lk(handler->m_mutex);
+    ids = handler->m_ids;
+  }
+  std::thread closer([&ids]() {
+    for (auto id: ids)
+      s.close(id);
+  });
+  for (auto& c: clients)
+    c->close();
+  closer.join();
+  std::cout << "closed from both ends: " << (waitForConnections(0) ? "all released" : "not all released") << std::endl;
+
+  s.stop();
+  return 0;
+}
+
+#endif
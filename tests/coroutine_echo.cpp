@@ -0,0 +1,80 @@
+#if !defined(WITH_ASIO) || !defined(WITH_COROUTINES)
+#warning "To run this sample, you should enable asio and coroutines in the cmakelists options."
+int main() { return 0; }
+#else
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <Net.h>
+
+using namespace thisptr::net;
+using namespace std::chrono_literals;
+
+const int kClients = 4;
+const int kMessages = 100;
+
+CoroutineTcpServer s(nullptr);
+std::atomic<int> echoed {0};
+
+asio::awaitable<void> session(std::shared_ptr<CoroutineTcpSocket> conn) {
+  while (true) {
+    auto [ec, data] = co_await conn->asyncRecv();
+    if (ec)
+      break;
+    auto [wec, bytes] = co_await conn->asyncSend(data);
+    if (wec)
+      break;
+  }
+  // the socket closes itself once the last reference is gone
+}
+
+asio::awaitable<void> acceptor() {
+  while (true) {
+    auto [ec, conn] = co_await s.asyncAccept();
+    if (ec)
+      break;
+    s.spawn(session(conn));
+  }
+}
+
+asio::awaitable<void> client(asio::io_context& context, int idx) {
+  auto conn = std::make_shared<CoroutineTcpSocket>(context);
+  if (!conn->connect("127.0.0.1", "7244")) {
+    std::cout << idx << " : unable to connect to host" << std::endl;
+    co_return;
+  }
+
+  std::string message = "ping " + std::to_string(idx);
+  for (int i = 0; i < kMessages; ++i) {
+    auto [wec, bytes] = co_await conn->asyncSend(asio::buffer(message));
+    std::size_t received = 0;
+    while (!wec && received < message.size()) {
+      auto [ec, data] = co_await conn->asyncRecv();
+      if (ec) {
+        std::cout << idx << " : connection closed or error occured" << std::endl;
+        co_return;
+      }
+      received += data.size();
+    }
+    echoed++;
+  }
+}
+
+int main() {
+  s.setWorkers(2);
+  if (!s.listen("127.0.0.1", "7244"))
+    return 1;
+  s.spawn(acceptor());
+
+  asio::io_context context;
+  for (int i = 0; i < kClients; ++i)
+    asio::co_spawn(context, client(context, i), asio::detached);
+  context.run();
+
+  std::cout << "echoed " << echoed << " of " << kClients * kMessages << " messages" << std::endl;
+  s.stop();
+  return 0;
+}
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef __linux__
+#warning "This sample needs epoll, it only runs on linux."
+int main() { return 0; }
+#else
+
+#include <iostream>
+
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include <thread>
+#include <EpollServer.h>
+
+using namespace thisptr::net;
+
+class EchoConnectionHandler: public BlockingTcpHandler {
+public:
+  void onConnect() override {
+    std::cout << "new connection received" << std::endl;
+  }
+
+  void onDisconnect() override {
+    std::cout << "connection dropped" << std::endl;
+  }
+
+  void onMessage(std::string data) override {
+    std::cout << "new message received: " << data << std::endl;
+
+    int n = m_conn->send(data.c_str(), (int)data.length());
+    if (n < 0) {
+      std::cout << " : unable to send data to host" << std::endl;
+      m_conn->close();
+    }
+  }
+};
+
+EpollTcpServer<EchoConnectionHandler> s;
+
+// remembers what it received, and can close its socket from outside the reactor
+class RecordingHandler: public BlockingTcpHandler {
+public:
+  void onMessage(std::string data) override {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_received += data;
+  }
+
+  void closeConnection() { m_conn->close(); }
+
+  std::string received() {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    return m_received;
+  }
+
+private:
+  std::mutex m_mutex;
+  std::string m_received;
+};
+
+void client(int idx) {
+  TcpClient<BlockingTcpSocket> c;
+  if (!c.connect("127.0.0.1", "7233"))
+  {
+    std::cout << idx << " : unable to connect to host" << std::endl;
+    return;
+  }
+
+  std::stringstream ss;
+  ss << idx << " : " << "hello!\r\n";
+
+  int i = 0;
+  while (i++ < 3) {
+    int n = c.send(ss.str().c_str());
+    if (n <= 0) {
+      std::cout << idx << " : unable to send data to host" << std::endl;
+      return;
+    }
+
+    char buffer[256] = {0};
+    int res = c.recv(buffer, 256);
+    if (res <= 0) {
+      std::cout << idx << " : connection closed or error occured" << std::endl;
+      return;
+    }
+
+    std::string recData(buffer, res);
+    std::cout << idx << " : data:" << recData << std::endl;
+  }
+
+  if (!c.close()) {
+    std::cout << idx << " : unable to close socket" << std::endl;
+    return;
+  }
+}
+
+int main() {
+  using namespace std::chrono_literals;
+
+  s.setWorkers(2);
+  s.setNewHandler([]() -> std::shared_ptr<EchoConnectionHandler> {
+    return std::make_shared<EchoConnectionHandler>();
+  });
+  s.start("127.0.0.1", "7233");
+
+  std::vector<std::thread> threads;
+  for (int i = 1; i < 16; ++i)
+    threads.emplace_back([i](){ client(i); });
+  for(auto& t: threads)
+  {
+    t.join();
+  }
+
+  std::this_thread::sleep_for(500ms);
+  s.stop();
+  s.waitForFinished();
+
+  // the kernel hands the fd of a connection its handler closed to the next one, which must get its own data
+  std::mutex handlersMutex;
+  std::vector<std::shared_ptr<RecordingHandler>> handlers;
+  EpollTcpServer<RecordingHandler> reused;
+  reused.setWorkers(1);
+  reused.setNewHandler([&]() -> std::shared_ptr<RecordingHandler> {
+    std::lock_guard<std::mutex> lk(handlersMutex);
+    handlers.push_back(std::make_shared<RecordingHandler>());
+    return handlers.back();
+  });
+  reused.start("127.0.0.1", "7254");
+  auto handlerCount = [&]() {
+    std::lock_guard<std::mutex> lk(handlersMutex);
+    return handlers.size();
+  };
+
+  TcpClient<BlockingTcpSocket> first;
+  first.connect("127.0.0.1", "7254");
+  for (int i = 0; i < 100 && handlerCount() < 1; ++i)
+    std::this_thread::sleep_for(10ms);
+  std::this_thread::sleep_for(50ms);
+  // the second client's socket exists before the fd is freed, so the accept is the one to take it
+  BlockingTcpSocket second(::socket(AF_INET, SOCK_STREAM, 0));
+  handlers[0]->closeConnection();
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(7254);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ::connect((int)second.handle(), (sockaddr*)&addr, sizeof(addr));
+  for (int i = 0; i < 100 && handlerCount() < 2; ++i)
+    std::this_thread::sleep_for(10ms);
+  second.send("second");
+  std::string received;
+  for (int i = 0; i < 100 && handlerCount() >= 2 && (received = handlers[1]->received()) != "second"; ++i)
+    std::this_thread::sleep_for(10ms);
+  bool routed = received == "second" && handlers[0]->received().empty();
+  std::cout << "data on a reused fd: " << (routed ? "reached the new connection" : "misrouted") << std::endl;
+  first.close();
+  second.close();
+  reused.stop();
+  reused.waitForFinished();
+
+  return routed ? 0 : 1;
+}
+
+#endif
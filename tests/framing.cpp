@@ -0,0 +1,64 @@
+#ifndef __linux__
+#warning "This sample needs epoll, it only runs on linux."
+int main() { return 0; }
+#else
+
+#include <iostream>
+
+#include <atomic>
+#include <thread>
+#include <EpollServer.h>
+
+using namespace thisptr::net;
+
+std::atomic<int> frames {0};
+
+class FrameConnectionHandler: public BlockingTcpHandler {
+public:
+  FrameConnectionHandler() {
+    setFrameCodec(FrameCodec(FrameCodec::Prefix::Varint, 1024));
+  }
+
+  void onFrame(const char* data, std::size_t len) override {
+    std::cout << "new frame received: " << std::string(data, len) << std::endl;
+    ++frames;
+  }
+};
+
+EpollTcpServer<FrameConnectionHandler> s;
+
+int main() {
+  using namespace std::chrono_literals;
+
+  s.setWorkers(1);
+  s.setNewHandler([]() -> std::shared_ptr<FrameConnectionHandler> {
+    return std::make_shared<FrameConnectionHandler>();
+  });
+  s.start("127.0.0.1", "7236");
+
+  TcpClient<BlockingTcpSocket> c;
+  if (!c.connect("127.0.0.1", "7236"))
+  {
+    std::cout << "unable to connect to host" << std::endl;
+    return 1;
+  }
+
+  FrameCodec codec(FrameCodec::Prefix::Varint, 1024);
+  // three frames in a single write, then one frame split over two writes
+  std::string batch = codec.frame("first") + codec.frame("second") + codec.frame(std::string(200, 'x'));
+  std::string split = codec.frame("split frame");
+  c.send(batch.data(), (int)batch.size());
+  c.send(split.data(), 3);
+  std::this_thread::sleep_for(100ms);
+  c.send(split.data() + 3, (int)split.size() - 3);
+
+  std::this_thread::sleep_for(500ms);
+  c.close();
+  s.stop();
+  s.waitForFinished();
+
+  std::cout << "frames received: " << frames << std::endl;
+  return frames == 4 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef WITH_ASIO
+#warning "To run this sample, you should enable asio in the cmakelists options."
+int main() { return 0; }
+#else
+
+#include <iostream>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <Net.h>
+
+using namespace thisptr::net;
+using namespace std::chrono_literals;
+
+// counts every heap allocation in the process, steady state echo traffic should not add any
+static std::atomic<long> gAllocations {0};
+
+void* operator new(std::size_t size) {
+  gAllocations++;
+  if (void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+const int kWarmup = 1000;
+const int kMeasured = 10000;
+// well past the small string buffer, so every copy on the send path would show up
+const std::size_t kPayloadSize = 1024;
+
+class EchoServerHandler: public std::enable_shared_from_this<EchoServerHandler>,
+    public AsyncConnectionHandlerBase<AsioTcpSocket<EchoServerHandler>> {
+public:
+  bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {
+    return !ec;
+  }
+
+  bool onBufferReceived(asio::ip::tcp::socket& sock, std::error_code ec, asio::const_buffer payload) override {
+    if (ec)
+      return false;
+    m_conn->send(static_cast<const char*>(payload.data()), (int)payload.size());
+    return true;
+  }
+
+  void onDataSent(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {}
+
+  void onNewConnection(asio::ip::tcp::socket& sock) override {
+    m_conn = std::make_shared<AsioTcpSocket<EchoServerHandler>>(sock, this->shared_from_this());
+    m_conn->recv();
+  }
+
+private:
+  std::shared_ptr<AsioTcpSocket<EchoServerHandler>> m_conn;
+};
+
+class EchoClientHandler: public AsyncConnectionHandlerBase<AsioTcpSocket<EchoClientHandler>> {
+public:
+  void onConnected(asio::ip::tcp::socket& sock, const std::string& endpoint) override {
+    m_client->send(m_payload.data(), (int)m_payload.size());
+  }
+
+  bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {
+    return !ec;
+  }
+
+  bool onBufferReceived(asio::ip::tcp::socket& sock, std::error_code ec, asio::const_buffer payload) override {
+    if (ec) {
+      std::cerr << "[client] unable to read from socket, ec: " << ec << std::endl;
+      done = true;
+      return false;
+    }
+
+    // the echo may arrive in pieces, a round trip ends with the whole payload
+    m_received += payload.size();
+    if (m_received < kPayloadSize)
+      return true;
+    m_received -= kPayloadSize;
+
+    ++m_roundTrips;
+    if (m_roundTrips == kWarmup)
+      m_baseline = gAllocations.load();
+    if (m_roundTrips == kWarmup + kMeasured) {
+      allocations = gAllocations.load() - m_baseline;
+      done = true;
+      return false;
+    }
+    m_client->send(m_payload.data(), (int)m_payload.size());
+    return true;
+  }
+
+  void onDataSent(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {}
+
+  AsyncTcpClient<EchoClientHandler>* m_client {nullptr};
+  std::atomic<bool> done {false};
+  long allocations {-1};
+
+private:
+  std::string m_payload = std::string(kPayloadSize, 'x');
+  std::size_t m_received {0};
+  int m_roundTrips {0};
+  long m_baseline {0};
+};
+
+int main() {
+  auto shandler = std::make_shared<EchoServerHandler>();
+  AsyncTcpServer<EchoServerHandler> s(shandler);
+  s.start("127.0.0.1", "7235");
+
+  auto chandler = std::make_shared<EchoClientHandler>();
+  AsyncTcpClient<EchoClientHandler> c(chandler);
+  chandler->m_client = &c;
+  if (!c.connect("127.0.0.1", "7235"))
+  {
+    std::cout << "unable to connect to host" << std::endl;
+    return 1;
+  }
+  c.recv();
+
+  for (int i = 0; i < 300 && !chandler->done; ++i)
+    std::this_thread::sleep_for(100ms);
+
+  if (!chandler->done) {
+    std::cout << "echo loop did not finish" << std::endl;
+    return 1;
+  }
+
+  std::cout << "heap allocations during " << kMeasured << " echo round trips of " << kPayloadSize << " bytes: " << chandler->allocations << std::endl;
+  s.stop();
+  return chandler->allocations == 0 ? 0 : 1;
+}
+
+#endif
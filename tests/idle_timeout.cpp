@@ -0,0 +1,65 @@
+#ifndef __linux__
+#warning "This sample needs epoll, it only runs on linux."
+int main() { return 0; }
+#else
+
+#include <iostream>
+
+#include <thread>
+#include <EpollServer.h>
+
+using namespace thisptr::net;
+
+class EchoConnectionHandler: public BlockingTcpHandler {
+public:
+  void onMessage(std::string data) override {
+    m_conn->send(data.c_str(), (int)data.length());
+  }
+};
+
+EpollTcpServer<EchoConnectionHandler> s;
+
+int main() {
+  using namespace std::chrono_literals;
+
+  s.setWorkers(1);
+  s.setIdleTimeout(200ms);
+  s.setNewHandler([]() -> std::shared_ptr<EchoConnectionHandler> {
+    return std::make_shared<EchoConnectionHandler>();
+  });
+  s.start("127.0.0.1", "7240");
+
+  TcpClient<BlockingTcpSocket> active, silent;
+  if (!active.connect("127.0.0.1", "7240") || !silent.connect("127.0.0.1", "7240"))
+  {
+    std::cout << "unable to connect to host" << std::endl;
+    return 1;
+  }
+
+  // the server echoes nothing back to a silent client, so the read deadline fires first
+  silent.setReadTimeout(50ms);
+  char buffer[16] = {0};
+  int res = silent.recv(buffer, 4);
+  std::cout << "silent client read: " << (res == thisptr::net_p::NETE_Timedout ? "timed out" : "unexpected") << std::endl;
+  silent.setReadTimeout(0ms);
+
+  // keep one connection busy past the idle timeout
+  bool alive = true;
+  for (int i = 0; i < 8 && alive; ++i) {
+    std::this_thread::sleep_for(50ms);
+    alive = active.send("ping", 4) == 4 && active.recv(buffer, 4) == 4;
+  }
+  std::cout << "active client: " << (alive ? "still connected" : "dropped") << std::endl;
+
+  // by now the silent one has been idle for well over 200ms
+  res = silent.recv(buffer, 4);
+  std::cout << "silent client: " << (res == thisptr::net_p::NETE_Notconnected ? "dropped" : "still connected") << std::endl;
+
+  active.close();
+  silent.close();
+  s.stop();
+  s.waitForFinished();
+  return 0;
+}
+
+#endif
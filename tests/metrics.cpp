@@ -0,0 +1,73 @@
+#ifndef __linux__
+#warning "This sample needs epoll, it only runs on linux."
+int main() { return 0; }
+#else
+
+#include <iostream>
+
+#include <thread>
+#include <vector>
+#include <EpollServer.h>
+
+using namespace thisptr::net;
+
+class EchoConnectionHandler: public BlockingTcpHandler {
+public:
+  void onMessage(std::string data) override {
+    m_conn->send(data.c_str(), (int)data.length());
+  }
+};
+
+EpollTcpServer<EchoConnectionHandler> s;
+Metrics serverMetrics;
+
+void client(int idx) {
+  TcpClient<BlockingTcpSocket> c;
+  if (!c.connect("127.0.0.1", "7239"))
+  {
+    std::cout << idx << " : unable to connect to host" << std::endl;
+    return;
+  }
+
+  for (int i = 0; i < 10; ++i) {
+    char buffer[16] = {0};
+    if (c.send("ping", 4) != 4 || c.recv(buffer, 4) != 4) {
+      std::cout << idx << " : connection closed or error occured" << std::endl;
+      return;
+    }
+  }
+  c.close();
+}
+
+int main() {
+  using namespace std::chrono_literals;
+
+  s.setWorkers(2);
+  s.setMetrics(&serverMetrics);
+  s.setNewHandler([]() -> std::shared_ptr<EchoConnectionHandler> {
+    return std::make_shared<EchoConnectionHandler>();
+  });
+  s.start("127.0.0.1", "7239");
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i)
+    threads.emplace_back([i](){ client(i); });
+  for (auto& t: threads)
+    t.join();
+
+  std::this_thread::sleep_for(200ms);
+  MetricsSnapshot snapshot = serverMetrics.snapshot();
+  std::cout << snapshot.toJson() << std::endl;
+
+  s.stop();
+  s.waitForFinished();
+
+  bool bRes = snapshot.counter(Metrics::Accepts) == 4 &&
+              snapshot.counter(Metrics::ActiveConnections) == 0 &&
+              snapshot.counter(Metrics::BytesIn) == 4 * 10 * 4 &&
+              snapshot.counter(Metrics::BytesOut) == 4 * 10 * 4 &&
+              snapshot.distribution(Metrics::HandlerTime).count == (std::uint64_t)snapshot.counter(Metrics::Reads);
+  return bRes ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef WITH_ASIO
+#warning "To run this sample, you should enable asio in the cmakelists options."
+int main() { return 0; }
+#else
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <Net.h>
+
+using namespace thisptr::net;
+using namespace std::chrono_literals;
+
+class ClientHandler: public AsyncConnectionHandlerBase<AsioTcpSocket<ClientHandler>> {
+public:
+  void onConnected(asio::ip::tcp::socket& sock, const std::string& endpoint) override {
+    m_connected = true;
+  }
+
+  bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {
+    return !ec;
+  }
+
+  void onDataSent(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {}
+
+  std::atomic<bool> m_connected {false};
+};
+
+int main() {
+  SOCKET listener;
+  if (thisptr::net_p::listen(listener, "127.0.0.1", "7249") != thisptr::net_p::NETE_Success) {
+    std::cout << "unable to bind to host" << std::endl;
+    return 1;
+  }
+  std::atomic<bool> stop {false};
+  std::thread acceptor([listener, &stop]() {
+    while (!stop) {
+      SOCKET sock = thisptr::net_p::accept(listener);
+      if (sock != INVALID_SOCKET)
+        thisptr::net_p::close(sock);
+    }
+  });
+
+  ResolverCache cache;
+  cache.setTtl(300ms);
+
+  TcpClient<BlockingTcpSocket> first, second;
+  first.setResolverCache(&cache);
+  second.setResolverCache(&cache);
+  bool connected = first.connect("localhost", "7249");
+  bool cached = cache.find("localhost", "7249") != nullptr;
+  connected = connected && second.connect("localhost", "7249");
+  std::cout << "blocking connects: " << (connected ? "connected" : "failed")
+            << ", lookup cached: " << (cached ? "yes" : "no") << std::endl;
+
+  // the async path resolves without blocking and fills the same cache
+  cache.clear();
+  auto handler = std::make_shared<ClientHandler>();
+  {
+    AsyncTcpClient<ClientHandler> async(handler);
+    async.setResolverCache(&cache);
+    async.connect("localhost", "7249");
+    for (int i = 0; i < 100 && !handler->m_connected; ++i)
+      std::this_thread::sleep_for(10ms);
+    std::cout << "async connect: " << (handler->m_connected ? "connected" : "failed")
+              << ", lookup cached: " << (cache.find("localhost", "7249") ? "yes" : "no") << std::endl;
+    async.close();
+  }
+
+  std::this_thread::sleep_for(400ms);
+  std::cout << "entry after ttl: " << (cache.find("localhost", "7249") ? "still there" : "expired") << std::endl;
+
+  // nobody listens there, so the entry is dropped again and the next connect looks the name up afresh
+  TcpClient<BlockingTcpSocket> refused;
+  refused.setResolverCache(&cache);
+  refused.connect("localhost", "7250");
+  std::cout << "entry after failed connect: " << (cache.find("localhost", "7250") ? "kept" : "dropped") << std::endl;
+
+  const int kLookups = 2000;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kLookups; ++i)
+    freeaddrinfo(thisptr::net_p::addressinfo("localhost", "7249"));
+  auto uncached = std::chrono::steady_clock::now() - start;
+  cache.setTtl(60000ms);
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kLookups; ++i)
+    cache.resolve("localhost", "7249");
+  auto hits = std::chrono::steady_clock::now() - start;
+  std::cout << kLookups << " lookups: getaddrinfo "
+            << std::chrono::duration_cast<std::chrono::microseconds>(uncached).count() << "us, cached "
+            << std::chrono::duration_cast<std::chrono::microseconds>(hits).count() << "us" << std::endl;
+
+  first.close();
+  second.close();
+  stop = true;
+  TcpClient<BlockingTcpSocket> wake;
+  wake.connect("127.0.0.1", "7249");
+  acceptor.join();
+  thisptr::net_p::close(listener);
+  return 0;
+}
+
+#endif
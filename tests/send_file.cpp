@@ -0,0 +1,148 @@
+#ifndef WITH_ASIO
+#warning "To run this sample, you should enable asio in the cmakelists options."
+int main() { return 0; }
+#elif !defined(__linux__)
+#warning "This sample creates its files with posix calls, it only runs on linux."
+int main() { return 0; }
+#else
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <Net.h>
+
+using namespace thisptr::net;
+using namespace std::chrono_literals;
+
+const std::size_t kFileSize = 4 * 1024 * 1024 + 123;
+
+char pattern(std::size_t i) {
+  return (char)('a' + (i * 7 + i / 4096) % 26);
+}
+
+// accepts one connection on the listener and reads exactly len bytes from it
+std::string receive(SOCKET listener, std::size_t len) {
+  BlockingTcpSocket conn(thisptr::net_p::accept(listener));
+  std::string data;
+  std::vector<char> buffer(64 * 1024);
+  while (data.size() < len) {
+    int res = conn.recv(buffer.data(), (int)buffer.size());
+    if (res <= 0)
+      break;
+    data.append(buffer.data(), res);
+  }
+  return data;
+}
+
+bool matches(const std::string& data, std::size_t offset, std::size_t len) {
+  if (data.size() < offset + len)
+    return false;
+  for (std::size_t i = 0; i < len; ++i) {
+    if (data[offset + i] != pattern(i))
+      return false;
+  }
+  return true;
+}
+
+class FileSenderHandler: public AsyncConnectionHandlerBase<AsioTcpSocket<FileSenderHandler>> {
+public:
+  bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {
+    return !ec;
+  }
+
+  void onDataSent(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {}
+
+  void onFileSent(asio::ip::tcp::socket& sock, std::error_code ec, int fd, std::size_t sent) override {
+    std::cout << "asio: file segment sent, " << sent << " bytes" << (ec ? ", error: " + ec.message() : "") << std::endl;
+  }
+};
+
+int main() {
+  char path[] = "/tmp/netlib_send_file_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    std::cout << "unable to create temporary file" << std::endl;
+    return 1;
+  }
+  unlink(path);
+  {
+    std::vector<char> contents(kFileSize);
+    for (std::size_t i = 0; i < kFileSize; ++i)
+      contents[i] = pattern(i);
+    if (write(fd, contents.data(), contents.size()) != (ssize_t)contents.size()) {
+      std::cout << "unable to write temporary file" << std::endl;
+      return 1;
+    }
+  }
+
+  SOCKET listener;
+  if (thisptr::net_p::listen(listener, "127.0.0.1", "7242") != thisptr::net_p::NETE_Success) {
+    std::cout << "unable to bind to host" << std::endl;
+    return 1;
+  }
+
+  // blocking socket, straight from the page cache
+  {
+    std::string received;
+    std::thread peer([&]() { received = receive(listener, kFileSize); });
+    TcpClient<BlockingTcpSocket> c;
+    long long sent = c.connect("127.0.0.1", "7242") ? c.sendFile(fd, 0, kFileSize) : -1;
+    peer.join();
+    c.close();
+    std::cout << "blocking: " << sent << " bytes sent, " << (matches(received, 0, kFileSize) ? "contents match" : "contents differ") << std::endl;
+  }
+
+  // a pipe cannot be sent with sendfile, it goes through the splice fallback
+  {
+    const std::size_t len = 256 * 1024;
+    int fds[2];
+    if (pipe(fds) < 0) {
+      std::cout << "unable to create pipe" << std::endl;
+      return 1;
+    }
+    std::thread writer([&]() {
+      for (std::size_t i = 0; i < len; ++i) {
+        char c = pattern(i);
+        if (write(fds[1], &c, 1) != 1)
+          break;
+      }
+      close(fds[1]);
+    });
+
+    std::string received;
+    std::thread peer([&]() { received = receive(listener, len); });
+    TcpClient<BlockingTcpSocket> c;
+    long long sent = c.connect("127.0.0.1", "7242") ? c.sendFile(fds[0], 0, len) : -1;
+    writer.join();
+    peer.join();
+    c.close();
+    close(fds[0]);
+    std::cout << "pipe: " << sent << " bytes sent, " << (matches(received, 0, len) ? "contents match" : "contents differ") << std::endl;
+  }
+
+  // asio socket, the file segment is written in order with the payloads around it
+  {
+    std::string received;
+    std::thread peer([&]() { received = receive(listener, kFileSize + 8); });
+    asio::io_context context;
+    auto handler = std::make_shared<FileSenderHandler>();
+    auto sock = std::make_shared<AsioTcpSocket<FileSenderHandler>>(context, handler);
+    if (sock->connect("127.0.0.1", "7242")) {
+      sock->send("head", 4);
+      sock->sendFile(fd, 0, kFileSize);
+      sock->send("tail", 4);
+    }
+    context.run_for(10s);
+    peer.join();
+    sock->close();
+    bool ordered = received.compare(0, 4, "head") == 0 && matches(received, 4, kFileSize) &&
+        received.compare(kFileSize + 4, 4, "tail") == 0;
+    std::cout << "asio: " << received.size() << " bytes received, " << (ordered ? "contents match" : "contents differ") << std::endl;
+  }
+
+  close(fd);
+  thisptr::net_p::close(listener);
+  return 0;
+}
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef WITH_ASIO
+#warning "To run this sample, you should enable asio in the cmakelists options."
+int main() { return 0; }
+#else
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <Net.h>
+
+using namespace thisptr::net;
+using namespace std::chrono_literals;
+
+const int kThreads = 4;
+const int kMessages = 2000;
+
+class SenderHandler: public AsyncConnectionHandlerBase<AsioTcpSocket<SenderHandler>> {
+public:
+  bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {
+    return !ec;
+  }
+
+  void onDataSent(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {}
+};
+
+int main() {
+  SOCKET listener;
+  if (thisptr::net_p::listen(listener, "127.0.0.1", "7255") != thisptr::net_p::NETE_Success) {
+    std::cout << "unable to bind to host" << std::endl;
+    return 1;
+  }
+
+  // every message is "<thread> <sequence>\n", the peer checks that each thread's sequence arrives in order
+  std::vector<int> next(kThreads, 0);
+  bool ordered = true;
+  std::thread peer([&]() {
+    SOCKET sock = thisptr::net_p::accept(listener);
+    BlockingTcpSocket conn(sock);
+    std::string stream;
+    char buffer[16 * 1024];
+    int received = 0;
+    while (received < kThreads * kMessages) {
+      int res = conn.recv(buffer, sizeof(buffer));
+      if (res <= 0)
+        break;
+      stream.append(buffer, res);
+      std::size_t begin = 0, end;
+      while ((end = stream.find('\n', begin)) != std::string::npos) {
+        std::istringstream line(stream.substr(begin, end - begin));
+        int thread = -1, seq = -1;
+        line >> thread >> seq;
+        if (thread < 0 || thread >= kThreads || seq != next[thread])
+          ordered = false;
+        else
+          next[thread]++;
+        received++;
+        begin = end + 1;
+      }
+      stream.erase(0, begin);
+    }
+  });
+
+  asio::io_context context;
+  Metrics metrics;
+  auto handler = std::make_shared<SenderHandler>();
+  auto sock = std::make_shared<AsioTcpSocket<SenderHandler>>(context, handler);
+  sock->setMetrics(&metrics);
+  if (!sock->connect("127.0.0.1", "7255")) {
+    std::cout << "unable to connect to host" << std::endl;
+    return 1;
+  }
+
+  auto work = asio::make_work_guard(context);
+  std::thread io([&]() { context.run(); });
+
+  std::vector<std::thread> senders;
+  for (int t = 0; t < kThreads; ++t) {
+    senders.emplace_back([&, t]() {
+      for (int i = 0; i < kMessages; ++i) {
+        std::string message = std::to_string(t) + " " + std::to_string(i) + "\n";
+        sock->send(message.c_str(), (int)message.length());
+      }
+    });
+  }
+  for (auto& sender: senders)
+    sender.join();
+
+  peer.join();
+  sock->close();
+  work.reset();
+  io.join();
+  thisptr::net_p::close(listener);
+
+  bool complete = true;
+  for (int t = 0; t < kThreads; ++t)
+    complete = complete && next[t] == kMessages;
+  std::int64_t writes = metrics.snapshot().counter(Metrics::Writes);
+  std::cout << "messages from " << kThreads << " threads: " << (ordered && complete ? "in order" : "out of order or lost")
+            << std::endl;
+  std::cout << kThreads * kMessages << " sends went out in " << writes << " writes" << std::endl;
+  return ordered && complete && writes < kThreads * kMessages ? 0 : 1;
+}
+
+#endif
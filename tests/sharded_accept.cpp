@@ -0,0 +1,78 @@
+#if !defined(__linux__) || !defined(WITH_ASIO)
+#warning "This sample needs asio and SO_REUSEPORT (linux), enable asio in the cmakelists options."
+int main() { return 0; }
+#else
+
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include <Net.h>
+
+using namespace thisptr::net;
+using namespace std::chrono_literals;
+
+const int kWorkers = 4;
+const int kClients = 64;
+
+class ShardHandler: public AsyncConnectionHandlerBase<AsioTcpSocket<ShardHandler>> {
+public:
+  bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {
+    return !ec;
+  }
+
+  void onDataSent(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {}
+
+  // every listener is bound to its own worker's context, so the accepting thread tells the listener apart
+  void onNewConnection(asio::ip::tcp::socket& sock) override {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_listeners.insert(std::this_thread::get_id());
+    m_accepted++;
+  }
+
+  std::size_t listeners() {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    return m_listeners.size();
+  }
+
+  int accepted() {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    return m_accepted;
+  }
+
+private:
+  std::mutex m_mutex;
+  std::set<std::thread::id> m_listeners;
+  int m_accepted {0};
+};
+
+int main() {
+  auto handler = std::make_shared<ShardHandler>();
+  AsyncTcpServer<ShardHandler> s(handler);
+  s.setWorkers(kWorkers, true);
+  s.setShardedAccept(2);
+  s.start("127.0.0.1", "7252");
+
+  std::vector<std::unique_ptr<TcpClient<BlockingTcpSocket>>> clients;
+  for (int i = 0; i < kClients; ++i) {
+    clients.emplace_back(new TcpClient<BlockingTcpSocket>());
+    if (!clients.back()->connect("127.0.0.1", "7252")) {
+      std::cout << "unable to connect to host" << std::endl;
+      return 1;
+    }
+  }
+  for (int i = 0; i < 100 && handler->accepted() != kClients; ++i)
+    std::this_thread::sleep_for(10ms);
+
+  std::size_t listeners = handler->listeners();
+  std::cout << "accepted " << handler->accepted() << " of " << kClients << " connections on "
+            << listeners << " of " << kWorkers << " listeners" << std::endl;
+
+  for (auto& c: clients)
+    c->close();
+  s.stop();
+  return handler->accepted() == kClients && listeners > 1 ? 0 : 1;
+}
+
+#endif
@@ -4,7 +4,6 @@
 
 #include <iostream>
 #include <sstream>
-#include <unordered_map>
 #include <vector>
 #include <thread>
 #include <Net.h>
@@ -19,7 +18,6 @@ public:
 
   void onDisconnected(asio::ip::tcp::socket& sock) override {
     std::cout << "[server] client disconnected" << std::endl;
-    m_connections.erase(&sock);
   }
 
   bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {
@@ -38,17 +36,7 @@ public:
       std::cout << "[server] data sent, len: " << payload.length() << std::endl;
   }
 
-  void onNewConnection(asio::ip::tcp::socket& sock) override {
-    std::cout << "[server] on new connection" << std::endl;
-    auto socket = std::make_shared<AsioTcpSocket<ServerHandler>>(this->shared_from_this(), sock);
-    m_connections[&sock] = socket;
-
-    socket->send("hi from server.");
-    socket->recv();
-  }
-
-private:
-  std::unordered_map<asio::ip::tcp::socket *, std::shared_ptr<AsioTcpSocket<ServerHandler>>> m_connections;
+  void onNewConnection(asio::ip::tcp::socket& sock) override;
 };
 
 class ClientHandler: public AsyncConnectionHandlerBase<AsioTcpSocket<ClientHandler>> {
@@ -62,11 +50,16 @@ public:
   }
 
   bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {
+    return onBufferReceived(sock, ec, asio::buffer(payload));
+  }
+
+  bool onBufferReceived(asio::ip::tcp::socket& sock, std::error_code ec, asio::const_buffer payload) override {
     if (ec) {
       std::cerr << "[client] unable to read from socket, ec: " << ec << std::endl;
       return false;
-    } else
-      std::cout << "[client] data received: " << payload.c_str() << std::endl;
+    }
+    std::cout << "[client] data received: ";
+    std::cout.write(static_cast<const char*>(payload.data()), payload.size()) << std::endl;
     return true;
   }
 
@@ -82,6 +75,15 @@ public:
 auto handler = std::make_shared<ServerHandler>();
 AsyncTcpServer<ServerHandler> s(handler);
 
+void ServerHandler::onNewConnection(asio::ip::tcp::socket& sock) {
+  std::cout << "[server] on new connection" << std::endl;
+  // the server keeps the connection and frees it once the client goes away
+  auto* socket = s.connection(s.adopt(sock, this->shared_from_this()));
+
+  socket->send("hi from server.");
+  socket->recv();
+}
+
 void stopServer() {
   // stop server after 10 seconds
   std::this_thread::sleep_for(10000ms);
@@ -91,7 +93,7 @@ void stopServer() {
 void client(int idx) {
   std::this_thread::sleep_for(1000ms);
   auto chandler = std::make_shared<ClientHandler>();
-  AsioTcpSocket<ClientHandler> c(chandler);
+  AsyncTcpClient<ClientHandler> c(chandler);
   if (!c.connect("127.0.0.1", "7232"))
   {
     std::cout << idx << " : unable to connect to host" << std::endl;
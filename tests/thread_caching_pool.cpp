@@ -0,0 +1,76 @@
+#include <iostream>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <Pool.h>
+
+using namespace thisptr::utils;
+
+const int kThreads = 16;
+const int kRounds = 200000;
+const std::size_t kCapacity = 32;
+
+std::atomic<int> created {0};
+std::atomic<int> destroyed {0};
+std::atomic<int> live {0};
+std::atomic<int> peak {0};
+
+struct Object {
+  std::atomic<bool> inUse {false};
+};
+
+int main() {
+  std::atomic<int> doubleHanded {0};
+  std::atomic<int> popped {0};
+  {
+    ThreadCachingPool<Object> pool([]() {
+      created++;
+      int now = ++live;
+      int seen = peak.load();
+      while (now > seen && !peak.compare_exchange_weak(seen, now));
+      return new Object();
+    }, [](Object* o) {
+      destroyed++;
+      live--;
+      delete o;
+    }, kCapacity);
+
+    // every thread holds a few objects at once, so the pool runs dry and objects travel between threads
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&pool, &doubleHanded, &popped, t]() {
+        Object* held[4] = {};
+        for (int i = 0; i < kRounds; ++i) {
+          int slot = (i + t) % 4;
+          if (held[slot]) {
+            held[slot]->inUse = false;
+            pool.push(held[slot]);
+            held[slot] = nullptr;
+            continue;
+          }
+          Object* o = pool.pop(5);
+          if (!o)
+            continue;
+          popped++;
+          if (o->inUse.exchange(true))
+            doubleHanded++;
+          held[slot] = o;
+        }
+        for (auto o: held) {
+          if (o) {
+            o->inUse = false;
+            pool.push(o);
+          }
+        }
+      });
+    }
+    for (auto& t: threads)
+      t.join();
+  }
+
+  std::cout << "pops: " << popped << ", handed out twice: " << doubleHanded << std::endl;
+  std::cout << "created " << created << ", destroyed " << destroyed
+            << ", most alive at once " << peak << " of capacity " << kCapacity << std::endl;
+  return doubleHanded == 0 && created == destroyed && peak <= (int)kCapacity ? 0 : 1;
+}
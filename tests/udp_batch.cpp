@@ -0,0 +1,68 @@
+#include <iostream>
+
+#include <thread>
+#include <vector>
+#include <UdpSocket.h>
+
+using namespace thisptr::net;
+
+const int kDatagrams = 200;
+
+int main() {
+  UdpClient receiver;
+  if (!receiver.bind("127.0.0.1", "7237"))
+  {
+    std::cout << "r : unable to bind to host" << std::endl;
+    return 1;
+  }
+
+  std::thread sender([]() {
+    UdpClient c;
+    if (!c.connect("127.0.0.1", "7237"))
+    {
+      std::cout << "c : unable to connect to host" << std::endl;
+      return;
+    }
+
+    std::vector<std::string> payloads;
+    std::vector<Datagram> batch(kDatagrams);
+    for (int i = 0; i < kDatagrams; ++i)
+      payloads.push_back("datagram " + std::to_string(i));
+    for (int i = 0; i < kDatagrams; ++i) {
+      batch[i].data = &payloads[i][0];
+      batch[i].size = payloads[i].size();
+    }
+
+    // small bursts, so the receive buffer never overflows
+    for (int i = 0; i < kDatagrams; i += 20) {
+      int n = c.sendBatch(&batch[i], 20);
+      if (n != 20)
+        std::cout << "c : unable to send datagrams, res: " << n << std::endl;
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  });
+
+  char storage[UdpSocket::kMaxBatch][64];
+  Datagram batch[UdpSocket::kMaxBatch];
+  for (int i = 0; i < UdpSocket::kMaxBatch; ++i) {
+    batch[i].data = storage[i];
+    batch[i].capacity = sizeof(storage[i]);
+  }
+
+  int received = 0, calls = 0;
+  while (received < kDatagrams) {
+    int n = receiver.recvBatch(batch, UdpSocket::kMaxBatch);
+    if (n < 0) {
+      std::cout << "r : unable to receive datagrams, res: " << n << std::endl;
+      break;
+    }
+    received += n;
+    ++calls;
+  }
+
+  sender.join();
+  std::cout << "r : " << received << " datagrams in " << calls << " calls, last from "
+            << batch[0].peer.address() << ":" << batch[0].peer.port() << std::endl;
+  receiver.close();
+  return received == kDatagrams ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+#ifndef WITH_URING
+#warning "To run this sample, you should enable io_uring in the cmakelists options."
+int main() { return 0; }
+#else
+
+#include <iostream>
+
+#include <sstream>
+#include <vector>
+#include <thread>
+#include <UringServer.h>
+
+using namespace thisptr::net;
+
+class EchoConnectionHandler: public BlockingTcpHandler {
+public:
+  void onConnect() override {
+    std::cout << "new connection received" << std::endl;
+  }
+
+  void onDisconnect() override {
+    std::cout << "connection dropped" << std::endl;
+  }
+
+  void onMessage(std::string data) override {
+    std::cout << "new message received: " << data << std::endl;
+
+    // queued on the io_uring loop, goes out with the next batched submission
+    int n = m_conn->send(data.c_str(), (int)data.length());
+    if (n < 0) {
+      std::cout << " : unable to send data to host" << std::endl;
+      m_conn->close();
+    }
+  }
+};
+
+UringTcpServer<EchoConnectionHandler> s;
+
+void client(int idx) {
+  TcpClient<BlockingTcpSocket> c;
+  if (!c.connect("127.0.0.1", "7234"))
+  {
+    std::cout << idx << " : unable to connect to host" << std::endl;
+    return;
+  }
+
+  std::stringstream ss;
+  ss << idx << " : " << "hello!\r\n";
+
+  int i = 0;
+  while (i++ < 3) {
+    int n = c.send(ss.str().c_str());
+    if (n <= 0) {
+      std::cout << idx << " : unable to send data to host" << std::endl;
+      return;
+    }
+
+    char buffer[256] = {0};
+    int res = c.recv(buffer, 256);
+    if (res <= 0) {
+      std::cout << idx << " : connection closed or error occured" << std::endl;
+      return;
+    }
+
+    std::string recData(buffer, res);
+    std::cout << idx << " : data:" << recData << std::endl;
+  }
+
+  if (!c.close()) {
+    std::cout << idx << " : unable to close socket" << std::endl;
+    return;
+  }
+}
+
+int main() {
+  using namespace std::chrono_literals;
+
+  s.setNewHandler([]() -> std::shared_ptr<EchoConnectionHandler> {
+    return std::make_shared<EchoConnectionHandler>();
+  });
+  s.start("127.0.0.1", "7234");
+  if (s.isFallback())
+    std::cout << "io_uring is not supported here, running on epoll" << std::endl;
+
+  std::vector<std::thread> threads;
+  for (int i = 1; i < 16; ++i)
+    threads.emplace_back([i](){ client(i); });
+  for(auto& t: threads)
+  {
+    t.join();
+  }
+
+  std::this_thread::sleep_for(500ms);
+  s.stop();
+  s.waitForFinished();
+
+  return 0;
+}
+
+#endif
@@ -0,0 +1,101 @@
+#include <iostream>
+
+#include <atomic>
+#include <thread>
+#include <Net.h>
+
+using namespace thisptr::net;
+using namespace std::chrono_literals;
+
+std::atomic<int> created {0};
+std::atomic<int> removed {0};
+std::atomic<int> resets {0};
+
+// answers with how many messages it has seen, which stays at one if no state carries over between connections
+class CountingHandler: public BlockingTcpHandler {
+public:
+  void reset() {
+    m_messages = 0;
+  }
+
+  void onMessage(std::string data) override {
+    std::string reply = std::to_string(++m_messages);
+    m_conn->send(reply.c_str(), (int)reply.length());
+  }
+
+private:
+  int m_messages {0};
+};
+
+std::string ping(TcpClient<BlockingTcpSocket>& c) {
+  char buffer[16] = {0};
+  if (c.send("ping", 4) != 4)
+    return "";
+  int res = c.recv(buffer, sizeof(buffer));
+  return res > 0 ? std::string(buffer, res) : "";
+}
+
+int main() {
+  bool reused = false;
+  auto start = std::chrono::steady_clock::now();
+  {
+    BlockingTcpServer<CountingHandler> s;
+    s.setWorkerPool(2, 1);
+    s.setNewHandler([]() -> std::shared_ptr<CountingHandler> {
+      created++;
+      return std::make_shared<CountingHandler>();
+    });
+    s.setRemoveHandler([](std::shared_ptr<CountingHandler>) { removed++; });
+    s.setResetHandler([](CountingHandler& h) {
+      resets++;
+      h.reset();
+    });
+    s.start("127.0.0.1", "7251");
+    std::this_thread::sleep_for(100ms);
+
+    bool fresh = true;
+    for (int i = 0; i < 4; ++i) {
+      TcpClient<BlockingTcpSocket> c;
+      if (!c.connect("127.0.0.1", "7251"))
+      {
+        std::cout << "unable to connect to host" << std::endl;
+        return 1;
+      }
+      fresh = fresh && ping(c) == "1" && ping(c) == "2";
+    }
+    std::cout << "handler state per connection: " << (fresh ? "fresh" : "carried over") << std::endl;
+    // the workers only notice the closed clients a moment later
+    for (int i = 0; i < 100 && resets < 4; ++i)
+      std::this_thread::sleep_for(10ms);
+    std::cout << "handlers for 4 connections: created " << created << " reset " << resets << std::endl;
+    reused = created < 4 && resets == 4 && removed == 0;
+
+    // both workers busy and the one queue slot taken, the next connection is refused
+    TcpClient<BlockingTcpSocket> a, b, queued, refused;
+    // one at a time, each has to leave the queue before the next one arrives
+    a.connect("127.0.0.1", "7251");
+    bool served = ping(a) == "1";
+    b.connect("127.0.0.1", "7251");
+    served = ping(b) == "1" && served;
+    queued.connect("127.0.0.1", "7251");
+    std::this_thread::sleep_for(100ms);
+    refused.connect("127.0.0.1", "7251");
+    char buffer[16];
+    int res = refused.recv(buffer, sizeof(buffer));
+    std::cout << "connection past the queue: " << (served && res <= 0 ? "refused" : "accepted") << std::endl;
+
+    // the queued one is served as soon as a worker is free
+    a.close();
+    std::cout << "queued connection: " << (ping(queued) == "1" ? "served" : "lost") << std::endl;
+
+    // b and queued are still connected, stopping must end them instead of waiting for the clients
+    s.stop();
+    res = b.recv(buffer, sizeof(buffer));
+    std::cout << "connection in progress after stop: " << (res <= 0 ? "ended" : "still served") << std::endl;
+  }
+  auto took = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  std::cout << "server destroyed, handlers created " << created << " removed " << removed
+            << " in " << took.count() << "ms" << std::endl;
+  // the pool never holds more than workers + maxPending handlers
+  return reused && created <= 3 && created == removed ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+#ifndef WITH_ASIO
+#warning "To run this sample, you should enable asio in the cmakelists options."
+int main() { return 0; }
+#elif !defined(__linux__)
+#warning "MSG_ZEROCOPY is linux only."
+int main() { return 0; }
+#else
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <Net.h>
+
+using namespace thisptr::net;
+using namespace std::chrono_literals;
+
+const std::size_t kPayloadSize = 1024 * 1024;
+const std::size_t kThreshold = 64 * 1024;
+const int kPayloads = 16;
+
+// accepts one connection and checks that every payload arrives intact, reading only after delay
+void receive(SOCKET listener, std::size_t& received, bool& intact,
+             std::chrono::milliseconds delay = std::chrono::milliseconds(0)) {
+  BlockingTcpSocket conn(thisptr::net_p::accept(listener));
+  std::this_thread::sleep_for(delay);
+  std::vector<char> buffer(64 * 1024);
+  received = 0;
+  intact = true;
+  while (received < kPayloadSize * kPayloads) {
+    int res = conn.recv(buffer.data(), (int)buffer.size());
+    if (res <= 0)
+      break;
+    for (int i = 0; i < res; ++i)
+      intact = intact && buffer[i] == (char)('a' + (received + i) / kPayloadSize);
+    received += res;
+  }
+}
+
+std::string payload(int idx) {
+  return std::string(kPayloadSize, (char)('a' + idx));
+}
+
+class SenderHandler: public AsyncConnectionHandlerBase<AsioTcpSocket<SenderHandler>> {
+public:
+  bool onDataReceived(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {
+    return !ec;
+  }
+
+  void onDataSent(asio::ip::tcp::socket& sock, std::error_code ec, const std::string& payload) override {}
+};
+
+int main() {
+  SOCKET listener;
+  if (thisptr::net_p::listen(listener, "127.0.0.1", "7243") != thisptr::net_p::NETE_Success) {
+    std::cout << "unable to bind to host" << std::endl;
+    return 1;
+  }
+
+  {
+    std::size_t received;
+    bool intact;
+    std::thread peer([&]() { receive(listener, received, intact); });
+    TcpClient<BlockingTcpSocket> c;
+    if (!c.connect("127.0.0.1", "7243") || !c.setZeroCopyThreshold(kThreshold)) {
+      std::cout << "blocking: zero-copy is not available" << std::endl;
+    } else {
+      for (int i = 0; i < kPayloads; ++i)
+        c.send(payload(i));
+    }
+    peer.join();
+    bool flushed = c.flushZeroCopy(1s);
+    c.close();
+    std::cout << "blocking: " << received << " bytes received" << (intact ? ", intact" : ", corrupted")
+              << (flushed ? ", all payloads released" : ", payloads still held") << std::endl;
+  }
+
+  // closing right after the sends must not wait for the kernel, the payloads it still reads from outlive the socket
+  {
+    std::size_t received;
+    bool intact;
+    std::thread peer([&]() { receive(listener, received, intact); });
+    TcpClient<BlockingTcpSocket> c;
+    std::chrono::milliseconds took {0};
+    if (!c.connect("127.0.0.1", "7243") || !c.setZeroCopyThreshold(kThreshold)) {
+      std::cout << "blocking close: zero-copy is not available" << std::endl;
+    } else {
+      for (int i = 0; i < kPayloads; ++i)
+        c.send(payload(i));
+      auto start = std::chrono::steady_clock::now();
+      c.close();
+      took = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    }
+    peer.join();
+    std::size_t retired = ZeroCopyTracker::reapRetired();
+    for (int i = 0; i < 100 && retired > 0; ++i) {
+      std::this_thread::sleep_for(10ms);
+      retired = ZeroCopyTracker::reapRetired();
+    }
+    std::cout << "blocking close: took " << took.count() << "ms, " << received << " bytes received"
+              << (intact ? ", intact" : ", corrupted")
+              << (retired == 0 ? ", all payloads released" : ", payloads still held") << std::endl;
+  }
+
+  {
+    std::size_t received;
+    bool intact;
+    std::thread peer([&]() { receive(listener, received, intact); });
+    asio::io_context context;
+    auto handler = std::make_shared<SenderHandler>();
+    auto sock = std::make_shared<AsioTcpSocket<SenderHandler>>(context, handler);
+    if (!sock->connect("127.0.0.1", "7243") || !sock->setZeroCopyThreshold(kThreshold)) {
+      std::cout << "asio: zero-copy is not available" << std::endl;
+    } else {
+      for (int i = 0; i < kPayloads; ++i)
+        sock->send(payload(i));
+    }
+    // runs until every write completed and the kernel released every payload
+    context.run_for(10s);
+    peer.join();
+    std::size_t held = sock->zeroCopyPending();
+    sock->close();
+    std::cout << "asio: " << received << " bytes received" << (intact ? ", intact" : ", corrupted")
+              << (held == 0 ? ", all payloads released" : ", payloads still held") << std::endl;
+  }
+
+  // the peer only reads once the socket is gone, so the kernel still holds the payloads when it closes
+  {
+    std::size_t received;
+    bool intact;
+    std::thread peer([&]() { receive(listener, received, intact, 300ms); });
+    asio::io_context context;
+    auto handler = std::make_shared<SenderHandler>();
+    auto sock = std::make_shared<AsioTcpSocket<SenderHandler>>(context, handler);
+    std::size_t held = 0;
+    if (!sock->connect("127.0.0.1", "7243") || !sock->setZeroCopyThreshold(kThreshold)) {
+      std::cout << "asio close: zero-copy is not available" << std::endl;
+    } else {
+      for (int i = 0; i < kPayloads; ++i)
+        sock->send(payload(i));
+      for (int i = 0; i < 1000 && sock->pendingBytes() > 0; ++i)
+        context.run_for(1ms);
+      held = sock->zeroCopyPending();
+      sock->close();
+      // the completions the close aborted still refer to the socket
+      context.restart();
+      context.run();
+    }
+    sock.reset();
+    peer.join();
+    std::size_t retired = ZeroCopyTracker::reapRetired();
+    for (int i = 0; i < 100 && retired > 0; ++i) {
+      std::this_thread::sleep_for(10ms);
+      retired = ZeroCopyTracker::reapRetired();
+    }
+    std::cout << "asio close: " << held << " payloads held at close, " << received << " bytes received"
+              << (intact ? ", intact" : ", corrupted")
+              << (retired == 0 ? ", all payloads released" : ", payloads still held") << std::endl;
+  }
+
+  thisptr::net_p::close(listener);
+  return 0;
+}
+
+#endif